@@ -23,6 +23,7 @@
 */
 
 #include <stdio.h>
+#include <malloc.h>
 #include "Arduino.h"
 #include "HardwareSerial.h"
 
@@ -309,12 +310,68 @@ void HardwareSerial::init(PinName _rx, PinName _tx, PinName _rts, PinName _cts)
   _serial.pin_tx = _tx;
   _serial.pin_rts = _rts;
   _serial.pin_cts = _cts;
-  _serial.rx_buff = _rx_buffer;
+  // Not started: setBuffers() (called by derived constructors) checks it
+  _serial.handle.gState = HAL_UART_STATE_RESET;
+  _serial.rx_buff = NULL;
+  _serial.rx_buff_size = 0;
   _serial.rx_head = 0;
   _serial.rx_tail = 0;
-  _serial.tx_buff = _tx_buffer;
+  _serial.tx_buff = NULL;
+  _serial.tx_buff_size = 0;
   _serial.tx_head = 0;
   _serial.tx_tail = 0;
+  _buffers_allocated = false;
+  _tx_reserved = 0;
+  _fifo = false;
+  _frame = false;
+  _frame_gap = 0;
+  _serial.frame_mode = UART_FRAME_NONE;
+  _serial.frame_head = 0;
+  _serial.frame_tail = 0;
+  _serial.frame_callback = NULL;
+  resetStats();
+#if defined(UART_DMA_ENABLED)
+  _serial.dma_rx = NULL;
+  _serial.dma_rx_request = 0;
+  _serial.rx_dma_size = 0;
+  _serial.rx_dma_lapped = 0;
+  _serial.dma_tx = NULL;
+  _serial.dma_tx_request = 0;
+#endif
+}
+
+void HardwareSerial::setBuffers(uint8_t *rx_buffer, uint16_t rx_size, uint8_t *tx_buffer, uint16_t tx_size)
+{
+  // The interrupt or the DMA of a running port still access the current
+  // buffers: send the pending data and stop it before releasing them
+  if (_serial.handle.gState != HAL_UART_STATE_RESET) {
+    end();
+  }
+  if (_buffers_allocated) {
+    free(_serial.rx_buff);
+    free(_serial.tx_buff);
+    _buffers_allocated = false;
+  }
+  _serial.rx_buff = rx_buffer;
+  _serial.rx_buff_size = rx_size;
+  _serial.rx_head = 0;
+  _serial.rx_tail = 0;
+  _serial.tx_buff = tx_buffer;
+  _serial.tx_buff_size = tx_size;
+  _serial.tx_head = 0;
+  _serial.tx_tail = 0;
+  _tx_reserved = 0;
+}
+
+static uint8_t *allocateBuffer(size_t size)
+{
+#if defined(UART_DMA_ENABLED) && defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  // Buffers accessed by the DMA must not share data cache lines
+  size = (size + DMA_DCACHE_LINE_SIZE - 1) & ~(DMA_DCACHE_LINE_SIZE - 1);
+  return (uint8_t *)memalign(DMA_DCACHE_LINE_SIZE, size);
+#else
+  return (uint8_t *)malloc(size);
+#endif
 }
 
 void HardwareSerial::configForLowPower(void)
@@ -336,7 +393,11 @@ void HardwareSerial::_rx_complete_irq(serial_t *obj)
 
   if (uart_getc(obj, &c) == 0) {
 
-    rx_buffer_index_t i = (unsigned int)(obj->rx_head + 1) % SERIAL_RX_BUFFER_SIZE;
+    rx_buffer_index_t i = obj->rx_head + 1;
+    if (i == obj->rx_buff_size) {
+      i = 0;
+    }
+    obj->stats.rx_bytes++;
 
     // if we should be storing the received character into the location
     // just before the tail (meaning that the head would advance to the
@@ -345,6 +406,9 @@ void HardwareSerial::_rx_complete_irq(serial_t *obj)
     if (i != obj->rx_tail) {
       obj->rx_buff[obj->rx_head] = c;
       obj->rx_head = i;
+      serial_stats_rx_peak(obj);
+    } else {
+      obj->stats.rx_overflows++;
     }
   }
 }
@@ -354,17 +418,22 @@ void HardwareSerial::_rx_complete_irq(serial_t *obj)
 int HardwareSerial::_tx_complete_irq(serial_t *obj)
 {
   size_t remaining_data;
+  tx_buffer_index_t head;
+  tx_buffer_index_t tail = obj->tx_tail + obj->tx_size;
+  obj->stats.tx_bytes += obj->tx_size;
   // previous HAL transfer is finished, move tail pointer accordingly
-  obj->tx_tail = (obj->tx_tail + obj->tx_size) % SERIAL_TX_BUFFER_SIZE;
+  if (tail >= obj->tx_buff_size) {
+    tail -= obj->tx_buff_size;
+  }
+  obj->tx_tail = tail;
 
   // If buffer is not empty (head != tail), send remaining data
-  if (obj->tx_head != obj->tx_tail) {
-    remaining_data = (SERIAL_TX_BUFFER_SIZE + obj->tx_head - obj->tx_tail)
-                     % SERIAL_TX_BUFFER_SIZE;
+  head = obj->tx_head;
+  if (head != tail) {
     // Limit the next transmission to the buffer end
     // because HAL is not able to manage rollover
-    obj->tx_size = min(remaining_data,
-                       (size_t)(SERIAL_TX_BUFFER_SIZE - obj->tx_tail));
+    remaining_data = (head > tail) ? head - tail : obj->tx_buff_size - tail;
+    obj->tx_size = remaining_data;
     uart_attach_tx_callback(obj, _tx_complete_irq, obj->tx_size);
     return -1;
   }
@@ -374,6 +443,16 @@ int HardwareSerial::_tx_complete_irq(serial_t *obj)
 
 // Public Methods //////////////////////////////////////////////////////////////
 
+void HardwareSerial::begin(unsigned long baud, uint8_t config, uint8_t *rx_buffer, uint16_t rx_size,
+                           uint8_t *tx_buffer, uint16_t tx_size)
+{
+  if ((rx_buffer == NULL) || (rx_size < 2) || (tx_buffer == NULL) || (tx_size < 2)) {
+    Error_Handler();
+  }
+  setBuffers(rx_buffer, rx_size, tx_buffer, tx_size);
+  begin(baud, config);
+}
+
 void HardwareSerial::begin(unsigned long baud, byte config)
 {
   uint32_t databits = 0;
@@ -433,9 +512,35 @@ void HardwareSerial::begin(unsigned long baud, byte config)
       break;
   }
 
+  // Allocate default buffers if no storage has been provided
+  if (_serial.rx_buff == NULL) {
+    _serial.rx_buff = allocateBuffer(SERIAL_RX_BUFFER_SIZE);
+    _serial.tx_buff = allocateBuffer(SERIAL_TX_BUFFER_SIZE);
+    if ((_serial.rx_buff == NULL) || (_serial.tx_buff == NULL)) {
+      Error_Handler();
+    }
+    _serial.rx_buff_size = SERIAL_RX_BUFFER_SIZE;
+    _serial.tx_buff_size = SERIAL_TX_BUFFER_SIZE;
+    _buffers_allocated = true;
+  }
+
   uart_init(&_serial, (uint32_t)baud, databits, parity, stopbits);
+#if defined(USART_CR1_FIFOEN)
+  if (_fifo) {
+    uart_enable_fifo(&_serial);
+  }
+#endif
   enableHalfDuplexRx();
-  uart_attach_rx_callback(&_serial, _rx_complete_irq);
+#if defined(UART_DMA_ENABLED)
+  uart_attach_tx_dma(&_serial);
+  if (!uart_attach_rx_dma(&_serial, _serial.rx_buff_size))
+#endif
+  {
+    uart_attach_rx_callback(&_serial, _rx_complete_irq);
+  }
+  if (_frame) {
+    uart_enable_frame(&_serial, _frame_gap);
+  }
 }
 
 void HardwareSerial::end()
@@ -447,15 +552,49 @@ void HardwareSerial::end()
 
   // clear any received data
   _serial.rx_head = _serial.rx_tail;
+#if defined(UART_DMA_ENABLED)
+  _serial.rx_dma_lapped = 0;
+#endif
 }
 
+#if defined(UART_DMA_ENABLED)
+// The circular DMA overwrote unread data: drop the oldest ones by moving
+// the tail just after the head, the newest rx_buff_size - 1 bytes are kept
+void HardwareSerial::resyncRx(void)
+{
+  if (_serial.rx_dma_lapped) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    rx_buffer_index_t tail = _serial.rx_head + 1;
+    if (tail == _serial.rx_buff_size) {
+      tail = 0;
+    }
+    _serial.rx_tail = tail;
+    _serial.rx_dma_lapped = 0;
+    __set_PRIMASK(primask);
+  }
+}
+#endif
+
 int HardwareSerial::available(void)
 {
-  return ((unsigned int)(SERIAL_RX_BUFFER_SIZE + _serial.rx_head - _serial.rx_tail)) % SERIAL_RX_BUFFER_SIZE;
+#if defined(UART_DMA_ENABLED)
+  resyncRx();
+#endif
+  rx_buffer_index_t head = _serial.rx_head;
+  rx_buffer_index_t tail = _serial.rx_tail;
+
+  if (head >= tail) {
+    return head - tail;
+  }
+  return _serial.rx_buff_size + head - tail;
 }
 
 int HardwareSerial::peek(void)
 {
+#if defined(UART_DMA_ENABLED)
+  resyncRx();
+#endif
   if (_serial.rx_head == _serial.rx_tail) {
     return -1;
   } else {
@@ -466,23 +605,157 @@ int HardwareSerial::peek(void)
 int HardwareSerial::read(void)
 {
   enableHalfDuplexRx();
+#if defined(UART_DMA_ENABLED)
+  resyncRx();
+#endif
   // if the head isn't ahead of the tail, we don't have any characters
   if (_serial.rx_head == _serial.rx_tail) {
     return -1;
   } else {
-    unsigned char c = _serial.rx_buff[_serial.rx_tail];
-    _serial.rx_tail = (rx_buffer_index_t)(_serial.rx_tail + 1) % SERIAL_RX_BUFFER_SIZE;
+    rx_buffer_index_t tail = _serial.rx_tail;
+    unsigned char c = _serial.rx_buff[tail];
+    if (++tail == _serial.rx_buff_size) {
+      tail = 0;
+    }
+    _serial.rx_tail = tail;
     return c;
   }
 }
 
+size_t HardwareSerial::read(uint8_t *buffer, size_t size)
+{
+  bool found;
+  // No terminator can match outside of the uint8_t range
+  return readUntil(-1, buffer, size, &found);
+}
+
+// Copy received data till terminator (consumed but not copied) or size.
+// Buffer is read with at most two copies: till its end then from its start.
+size_t HardwareSerial::readUntil(int terminator, uint8_t *buffer, size_t size, bool *found)
+{
+  size_t count = 0;
+
+  enableHalfDuplexRx();
+  *found = false;
+  while (count < size) {
+#if defined(UART_DMA_ENABLED)
+    resyncRx();
+#endif
+    rx_buffer_index_t head = _serial.rx_head;
+    rx_buffer_index_t tail = _serial.rx_tail;
+    if (head == tail) {
+      break;
+    }
+    size_t length = min((size_t)(((head > tail) ? head : _serial.rx_buff_size) - tail), size - count);
+    const uint8_t *start = &_serial.rx_buff[tail];
+    const uint8_t *end = (terminator < 0) ? NULL : (const uint8_t *)memchr(start, terminator, length);
+    if (end != NULL) {
+      length = end - start;
+      *found = true;
+    }
+    memcpy(buffer + count, start, length);
+    count += length;
+    tail += length + (*found ? 1 : 0);
+    if (tail == _serial.rx_buff_size) {
+      tail = 0;
+    }
+    _serial.rx_tail = tail;
+    if (*found) {
+      break;
+    }
+  }
+  return count;
+}
+
+size_t HardwareSerial::readBytes(char *buffer, size_t length)
+{
+  size_t count = 0;
+  size_t read_size;
+  _startMillis = millis();
+  do {
+    read_size = read(reinterpret_cast<uint8_t *>(buffer) + count, length - count);
+    count += read_size;
+    if (count == length) {
+      break;
+    }
+    // Timeout is reset on each received data as Stream::timedRead() does
+    if (read_size != 0) {
+      _startMillis = millis();
+    }
+  } while (millis() - _startMillis < _timeout);
+  return count;
+}
+
+size_t HardwareSerial::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+  size_t count = 0;
+  size_t read_size;
+  bool found;
+  _startMillis = millis();
+  do {
+    read_size = readUntil(static_cast<uint8_t>(terminator),
+                          reinterpret_cast<uint8_t *>(buffer) + count, length - count, &found);
+    count += read_size;
+    if (found || (count == length)) {
+      break;
+    }
+    if (read_size != 0) {
+      _startMillis = millis();
+    }
+  } while (millis() - _startMillis < _timeout);
+  return count;
+}
+
+size_t HardwareSerial::frameAvailable(void)
+{
+  uint8_t i = _serial.frame_tail;
+
+  if (i == _serial.frame_head) {
+    return 0;
+  }
+  rx_buffer_index_t end = _serial.frame_end[i];
+  rx_buffer_index_t tail = _serial.rx_tail;
+  return (end >= tail) ? end - tail : _serial.rx_buff_size + end - tail;
+}
+
+size_t HardwareSerial::readFrame(uint8_t *buffer, size_t size, uint32_t *timestamp)
+{
+  uint8_t i = _serial.frame_tail;
+
+  if (i == _serial.frame_head) {
+    return 0;
+  }
+  if (timestamp != NULL) {
+    *timestamp = _serial.frame_time[i];
+  }
+  // Data past the frame end are not available yet when its size is given
+  size_t count = read(buffer, min(frameAvailable(), size));
+  // Drop the part of the frame which does not fit in the buffer
+  _serial.rx_tail = _serial.frame_end[i];
+  _serial.frame_tail = (i + 1 == UART_FRAME_QUEUE_SIZE) ? 0 : i + 1;
+  return count;
+}
+
+serial_stats_t HardwareSerial::stats(void)
+{
+  return _serial.stats;
+}
+
+void HardwareSerial::resetStats(void)
+{
+  memset(&_serial.stats, 0, sizeof(_serial.stats));
+}
+
 int HardwareSerial::availableForWrite(void)
 {
   tx_buffer_index_t head = _serial.tx_head;
   tx_buffer_index_t tail = _serial.tx_tail;
 
+  if (_serial.tx_buff == NULL) {
+    return 0;
+  }
   if (head >= tail) {
-    return SERIAL_TX_BUFFER_SIZE - 1 - head + tail;
+    return _serial.tx_buff_size - 1 - head + tail;
   }
   return tail - head - 1;
 }
@@ -499,7 +772,7 @@ void HardwareSerial::flush(uint32_t timeout)
   // complete) bit to 1 during initialization
   if (_written) {
     uint32_t tickstart = HAL_GetTick();
-    while ((_serial.tx_head != _serial.tx_tail)) {
+    while ((_serial.tx_head != _serial.tx_tail) || serial_tx_active(&_serial)) {
       // the interrupt handler will free up space for us
       // Only manage timeout if any
       if ((timeout != 0) && ((HAL_GetTick() - tickstart) >= timeout)) {
@@ -518,20 +791,21 @@ size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
   size_t size_intermediate;
   size_t ret = size;
   size_t available = availableForWrite();
-  size_t available_till_buffer_end = SERIAL_TX_BUFFER_SIZE - _serial.tx_head;
+  size_t available_till_buffer_end = _serial.tx_buff_size - _serial.tx_head;
 
-  _written = true;
-  if (isHalfDuplex()) {
-    if (_rx_enabled) {
-      _rx_enabled = false;
-      uart_enable_tx(&_serial);
-    }
+  // Nothing can be sent before begin()
+  if (_serial.tx_buff == NULL) {
+    return 0;
   }
 
   // If the output buffer is full, there's nothing for it other than to
   // wait for the interrupt handler to free space
-  while (!availableForWrite()) {
-    // nop, the interrupt handler will free up space for us
+  if (!availableForWrite()) {
+    uint32_t start = micros();
+    while (!availableForWrite()) {
+      // nop, the interrupt handler will free up space for us
+    }
+    _serial.stats.tx_stall_us += micros() - start;
   }
 
   // HAL doesn't manage rollover, so split transfer till end of TX buffer
@@ -542,23 +816,44 @@ size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
     size -= size_intermediate;
     buffer += size_intermediate;
     available = availableForWrite();
-    available_till_buffer_end = SERIAL_TX_BUFFER_SIZE - _serial.tx_head;
+    available_till_buffer_end = _serial.tx_buff_size - _serial.tx_head;
   }
 
   // Copy data to buffer. Take into account rollover if necessary.
-  if (_serial.tx_head + size <= SERIAL_TX_BUFFER_SIZE) {
+  if (_serial.tx_head + size <= _serial.tx_buff_size) {
     memcpy(&_serial.tx_buff[_serial.tx_head], buffer, size);
     size_intermediate = size;
   } else {
     // memcpy till end of buffer then continue memcpy from beginning of buffer
-    size_intermediate = SERIAL_TX_BUFFER_SIZE - _serial.tx_head;
+    size_intermediate = _serial.tx_buff_size - _serial.tx_head;
     memcpy(&_serial.tx_buff[_serial.tx_head], buffer, size_intermediate);
     memcpy(&_serial.tx_buff[0], buffer + size_intermediate,
            size - size_intermediate);
   }
 
   // Data are copied to buffer, move head pointer accordingly
-  _serial.tx_head = (_serial.tx_head + size) % SERIAL_TX_BUFFER_SIZE;
+  size_t head = _serial.tx_head + size;
+  if (head >= _serial.tx_buff_size) {
+    head -= _serial.tx_buff_size;
+  }
+  _serial.tx_head = head;
+  startTransmit(size_intermediate);
+
+  /* There is no real error management so just return transfer size requested*/
+  return ret;
+}
+
+// Send the data added to the TX buffer, size is the contiguous part
+// starting at the previous head
+void HardwareSerial::startTransmit(size_t size)
+{
+  _written = true;
+  if (isHalfDuplex()) {
+    if (_rx_enabled) {
+      _rx_enabled = false;
+      uart_enable_tx(&_serial);
+    }
+  }
 
   // Transfer data with HAL only is there is no TX data transfer ongoing
   // otherwise, data transfer will be done asynchronously from callback
@@ -566,12 +861,65 @@ size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
     // note: tx_size correspond to size of HAL data transfer,
     // not the total amount of data in the buffer.
     // To compute size of data in buffer compare head and tail
-    _serial.tx_size = size_intermediate;
-    uart_attach_tx_callback(&_serial, _tx_complete_irq, size_intermediate);
+    _serial.tx_size = size;
+    uart_attach_tx_callback(&_serial, _tx_complete_irq, size);
   }
+}
 
-  /* There is no real error management so just return transfer size requested*/
-  return ret;
+uint8_t *HardwareSerial::reserveWrite(size_t size, size_t *available)
+{
+  uint32_t start = micros();
+  bool stalled = false;
+
+  if ((_serial.tx_buff == NULL) || (size >= _serial.tx_buff_size)) {
+    return NULL;
+  }
+  while (true) {
+    tx_buffer_index_t head = _serial.tx_head;
+    tx_buffer_index_t tail = _serial.tx_tail;
+    size_t length;
+
+    if ((head == tail) && (head != 0) && !serial_tx_active(&_serial)) {
+      // Nothing to send, restart from the buffer start for the largest area
+      _serial.tx_head = 0;
+      _serial.tx_tail = 0;
+      head = 0;
+      tail = 0;
+    }
+    if (head >= tail) {
+      length = _serial.tx_buff_size - head - ((tail == 0) ? 1 : 0);
+    } else {
+      length = tail - head - 1;
+    }
+    if (length >= size) {
+      if (stalled) {
+        _serial.stats.tx_stall_us += micros() - start;
+      }
+      if (available != NULL) {
+        *available = length;
+      }
+      _tx_reserved = length;
+      return &_serial.tx_buff[head];
+    }
+    // the interrupt handler will free up space for us
+    stalled = true;
+  }
+}
+
+size_t HardwareSerial::commitWrite(size_t size)
+{
+  // Bytes beyond the reserved area are not sent
+  if (size > _tx_reserved) {
+    size = _tx_reserved;
+  }
+  _tx_reserved = 0;
+  if ((_serial.tx_buff == NULL) || (size == 0)) {
+    return 0;
+  }
+  size_t head = _serial.tx_head + size;
+  _serial.tx_head = (head == _serial.tx_buff_size) ? 0 : head;
+  startTransmit(size);
+  return size;
 }
 
 size_t HardwareSerial::write(uint8_t c)
@@ -580,6 +928,17 @@ size_t HardwareSerial::write(uint8_t c)
   return write(&buff, 1);
 }
 
+void HardwareSerial::setFrameMode(bool enable, uint32_t gap)
+{
+  _frame = enable;
+  _frame_gap = gap;
+}
+
+void HardwareSerial::onFrame(void (*callback)(uint16_t length, uint32_t timestamp))
+{
+  _serial.frame_callback = callback;
+}
+
 void HardwareSerial::setRx(uint32_t _rx)
 {
   _serial.pin_rx = digitalPinToPinName(_rx);
@@ -642,6 +1001,25 @@ bool HardwareSerial::isHalfDuplex(void) const
   return _serial.pin_rx == NC;
 }
 
+void HardwareSerial::setFifo(bool enable)
+{
+  _fifo = enable;
+}
+
+#if defined(UART_DMA_ENABLED)
+void HardwareSerial::setRxDMA(dma_channel_t *instance, uint32_t request)
+{
+  _serial.dma_rx = instance;
+  _serial.dma_rx_request = request;
+}
+
+void HardwareSerial::setTxDMA(dma_channel_t *instance, uint32_t request)
+{
+  _serial.dma_tx = instance;
+  _serial.dma_tx_request = request;
+}
+#endif
+
 void HardwareSerial::enableHalfDuplexRx(void)
 {
   if (isHalfDuplex()) {
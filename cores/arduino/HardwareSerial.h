@@ -33,28 +33,25 @@
 // using a ring buffer (I think), in which head is the index of the location
 // to which to write the next incoming character and tail is the index of the
 // location from which to read.
-// NOTE: a "power of 2" buffer size is recommended to dramatically
-//       optimize all the modulo operations for ring buffers.
-// WARNING: When buffer sizes are increased to > 256, the buffer index
-// variables are automatically increased in size, but the extra
-// atomicity guards needed for that are not implemented. This will
-// often work, but occasionally a race condition can occur that makes
-// Serial behave erratically. See https://github.com/arduino/Arduino/issues/2405
+// SERIAL_TX_BUFFER_SIZE and SERIAL_RX_BUFFER_SIZE are the default sizes of
+// the buffers allocated by begin(). Each instance can use its own storage
+// (up to 65535 bytes) provided to begin() or with HardwareSerialBuffered.
+// Indexes are 16-bit, so read and written atomically, and each one is only
+// updated by one side (interrupt or application): no extra guard is needed
+// whatever the buffer size.
 #if !defined(SERIAL_TX_BUFFER_SIZE)
   #define SERIAL_TX_BUFFER_SIZE 64
 #endif
 #if !defined(SERIAL_RX_BUFFER_SIZE)
   #define SERIAL_RX_BUFFER_SIZE 64
 #endif
-#if (SERIAL_TX_BUFFER_SIZE>256)
-  typedef uint16_t tx_buffer_index_t;
+typedef uint16_t tx_buffer_index_t;
+typedef uint16_t rx_buffer_index_t;
+#if defined(UART_DMA_ENABLED) && defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  // Buffers accessed by the DMA must not share data cache lines
+  #define SERIAL_BUFFER_ALIGN __attribute__((aligned(DMA_DCACHE_LINE_SIZE)))
 #else
-  typedef uint8_t tx_buffer_index_t;
-#endif
-#if  (SERIAL_RX_BUFFER_SIZE>256)
-  typedef uint16_t rx_buffer_index_t;
-#else
-  typedef uint8_t rx_buffer_index_t;
+  #define SERIAL_BUFFER_ALIGN
 #endif
 
 // A bool should be enough for this
@@ -101,14 +98,16 @@ class HardwareSerial : public Stream {
     // Has any byte been written to the UART since begin()
     bool _written;
 
-    // Don't put any members after these buffers, since only the first
-    // 32 bytes of this struct can be accessed quickly using the ldd
-    // instruction.
-    unsigned char _rx_buffer[SERIAL_RX_BUFFER_SIZE];
-    unsigned char _tx_buffer[SERIAL_TX_BUFFER_SIZE];
+    // Buffers allocated by begin() when no storage is provided
+    bool _buffers_allocated;
+
+    // Size of the TX area given by reserveWrite(), not committed yet
+    size_t _tx_reserved;
 
     serial_t _serial;
 
+    void setBuffers(uint8_t *rx_buffer, uint16_t rx_size, uint8_t *tx_buffer, uint16_t tx_size);
+
   public:
     HardwareSerial(uint32_t _rx, uint32_t _tx, uint32_t _rts = NUM_DIGITAL_PINS, uint32_t _cts = NUM_DIGITAL_PINS);
     HardwareSerial(PinName _rx, PinName _tx, PinName _rts = NC, PinName _cts = NC);
@@ -120,10 +119,21 @@ class HardwareSerial : public Stream {
       begin(baud, SERIAL_8N1);
     }
     void begin(unsigned long, uint8_t);
+    // Use rx_buffer and tx_buffer as ring buffers instead of allocating
+    // default ones. One byte of each buffer is kept free. With DMA on
+    // Cortex-M7, rx_buffer has to be aligned on a 32-byte cache line.
+    void begin(unsigned long baud, uint8_t config, uint8_t *rx_buffer, uint16_t rx_size,
+               uint8_t *tx_buffer, uint16_t tx_size);
     void end();
     virtual int available(void);
     virtual int peek(void);
     virtual int read(void);
+    // Read available data without waiting, returns the number of bytes read
+    size_t read(uint8_t *buffer, size_t size);
+    virtual size_t readBytes(char *buffer, size_t length);
+    virtual size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    using Stream::readBytes;
+    using Stream::readBytesUntil;
     int availableForWrite(void);
     virtual void flush();
     void flush(uint32_t timeout);
@@ -170,6 +180,55 @@ class HardwareSerial : public Stream {
     bool isHalfDuplex(void) const;
     void enableHalfDuplexRx(void);
 
+    // Use the hardware FIFO (if any) to handle several bytes per interrupt,
+    // ignored if the U(S)ART instance has no FIFO.
+    // This needs to be done before the call to begin()
+    void setFifo(bool enable);
+
+#if defined(UART_DMA_ENABLED)
+    // Receive with a circular DMA instead of one interrupt per byte.
+    // Received data are available on idle line, half and full buffer events.
+    // The DMA does not wait for the reader: when it overwrites unread data,
+    // the oldest bytes are dropped and the newest rx buffer size - 1 bytes
+    // are kept (counted in stats().rx_overflows).
+    // request is the DMA request (or stream channel), unused on series with
+    // fixed DMA mapping. This needs to be done before the call to begin()
+    void setRxDMA(dma_channel_t *instance, uint32_t request = 0);
+    // Transmit each contiguous part of the TX buffer with a DMA transfer
+    // instead of one interrupt per byte.
+    // This needs to be done before the call to begin()
+    void setTxDMA(dma_channel_t *instance, uint32_t request = 0);
+#endif
+
+    // Zero-copy write: get a contiguous free area of the TX buffer to fill
+    // in place, waiting for at least size bytes, then send its first bytes
+    // with commitWrite(). Returns NULL if size exceeds the buffer capacity,
+    // the area size is returned in available (could be more than size).
+    // commitWrite() sends at most the area size and returns the bytes sent.
+    uint8_t *reserveWrite(size_t size, size_t *available = NULL);
+    size_t commitWrite(size_t size);
+
+    // Frame mode: received data are split in frames separated by an idle
+    // line during gap bit durations (receiver timeout), or one character
+    // if gap is 0 or if the instance has no receiver timeout (ex: F1, F4,
+    // LPUART or DMA reception). Do not mix with the byte read functions.
+    // This needs to be done before the call to begin()
+    void setFrameMode(bool enable, uint32_t gap = 0);
+    // Called from the interrupt handler at the end of each frame with its
+    // length and the micros() value when it has been detected
+    void onFrame(void (*callback)(uint16_t length, uint32_t timestamp));
+    // Length of the next complete frame, 0 if none
+    size_t frameAvailable(void);
+    // Read the next complete frame, its part not fitting in buffer is lost.
+    // Returns the number of bytes copied in buffer, 0 if no frame is
+    // complete, and the micros() value of the frame end in timestamp.
+    size_t readFrame(uint8_t *buffer, size_t size, uint32_t *timestamp = NULL);
+
+    // Link statistics since the creation of the instance or the last
+    // resetStats(): byte counts, rx buffer overflows, line errors...
+    serial_stats_t stats(void);
+    void resetStats(void);
+
     friend class STM32LowPower;
 
     // Interrupt handlers
@@ -186,12 +245,35 @@ class HardwareSerial : public Stream {
 
   private:
     bool _rx_enabled;
+    bool _fifo;
+    bool _frame;
+    uint32_t _frame_gap;
     uint8_t _config;
     unsigned long _baud;
     void init(PinName _rx, PinName _tx, PinName _rts = NC, PinName _cts = NC);
+    size_t readUntil(int terminator, uint8_t *buffer, size_t size, bool *found);
+#if defined(UART_DMA_ENABLED)
+    void resyncRx(void);
+#endif
+    void startTransmit(size_t size);
     void configForLowPower(void);
 };
 
+// HardwareSerial with statically allocated buffers of the given sizes
+template<uint16_t RX_SIZE, uint16_t TX_SIZE>
+class HardwareSerialBuffered : public HardwareSerial {
+  public:
+    template<typename... Args>
+    HardwareSerialBuffered(Args... args) : HardwareSerial(args...)
+    {
+      setBuffers(_rx_storage, RX_SIZE, _tx_storage, TX_SIZE);
+    }
+
+  private:
+    uint8_t _rx_storage[RX_SIZE] SERIAL_BUFFER_ALIGN;
+    uint8_t _tx_storage[TX_SIZE] SERIAL_BUFFER_ALIGN;
+};
+
 #if defined(USART1)
   extern HardwareSerial Serial1;
 #endif
@@ -89,6 +89,39 @@ size_t USBSerial::write(const uint8_t *buffer, size_t size)
   return size - rest;
 }
 
+uint8_t *USBSerial::reserveWrite(size_t size, size_t *available)
+{
+  uint16_t length;
+  uint8_t *block;
+
+  if (size > CDC_TRANSMIT_QUEUE_BUFFER_SIZE - 1U) {
+    return NULL;
+  }
+  while (CDC_connected()) {
+    // TS: as write(), only the main thread reserves space in the queue
+    block = CDC_TransmitQueue_ReserveBlock(&TransmitQueue, &length);
+    if (length >= size) {
+      if (available != NULL) {
+        *available = length;
+      }
+      return block;
+    }
+  }
+  return NULL;
+}
+
+size_t USBSerial::commitWrite(size_t size)
+{
+  // Bytes beyond the reserved block are not sent
+  size = CDC_TransmitQueue_CommitWrite(&TransmitQueue, (uint16_t)min(size, (size_t)UINT16_MAX));
+  if (size == 0) {
+    return 0;
+  }
+  // After storing data, start transmitting process
+  CDC_continue_transmit();
+  return size;
+}
+
 int USBSerial::available(void)
 {
   // Just ReceiveQueue size, available for reading
@@ -42,6 +42,9 @@ class USBSerial : public Stream {
     virtual size_t write(uint8_t);
     virtual size_t write(const uint8_t *buffer, size_t size);
     using Print::write; // pull in write(str) from Print
+    // Zero-copy write, same as HardwareSerial
+    uint8_t *reserveWrite(size_t size, size_t *available = NULL);
+    size_t commitWrite(size_t size);
     operator bool(void);
 
     // These return the settings specified by the USB host for the
@@ -0,0 +1,255 @@
+/*
+ *******************************************************************************
+ * Copyright (c) 2024, STMicroelectronics
+ * All rights reserved.
+ *
+ * This software component is licensed by ST under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ *******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DMA_H
+#define __DMA_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include "stm32_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Only the "legacy" DMA controllers (channel or stream based) are managed.
+ * GPDMA (STM32H5xx, STM32U5xx, STM32WBAxx), STM32MP1xx and the STM32WL
+ * Cortex-M0+ core are not supported: drivers fall back to interrupt mode.
+ */
+#if defined(HAL_DMA_MODULE_ENABLED) && !defined(HAL_DMA_MODULE_ONLY) &&\
+    (defined(DMA1_Channel1_BASE) || defined(DMA1_Stream0_BASE)) &&\
+    !defined(STM32MP1xx) && !defined(CORE_CM0PLUS)
+#define DMA_WRAPPER_ENABLED
+
+/*
+ * DMA IRQ handlers are only defined when at least one driver is built
+ * with DMA support, so that they do not conflict with user ones.
+ */
+#if defined(UART_DMA_ENABLED) || defined(SPI_DMA_ENABLED) || defined(QSPI_DMA_ENABLED) ||\
+    defined(I2C_DMA_ENABLED)
+#define DMA_IRQ_HANDLER_ENABLED
+#endif
+
+#ifndef DMA_IRQ_PRIO
+#define DMA_IRQ_PRIO        1
+#endif
+#ifndef DMA_IRQ_SUBPRIO
+#define DMA_IRQ_SUBPRIO     0
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+#if defined(DMA1_Stream0_BASE)
+typedef DMA_Stream_TypeDef dma_channel_t;
+#else
+typedef DMA_Channel_TypeDef dma_channel_t;
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+/* Max number of channels (or streams) per DMA controller */
+#define DMA_CHANNEL_PER_CONTROLLER  8
+#if defined(DMA2_BASE)
+#define DMA_NUM                     (2 * DMA_CHANNEL_PER_CONTROLLER)
+#else
+#define DMA_NUM                     DMA_CHANNEL_PER_CONTROLLER
+#endif
+/* Cortex-M7 data cache line size */
+#define DMA_DCACHE_LINE_SIZE        32U
+
+/* Shared DMA IRQ */
+#if defined(STM32C0xx)
+#define DMA1_Channel2_IRQn        DMA1_Channel2_3_IRQn
+#define DMA1_Channel3_IRQn        DMA1_Channel2_3_IRQn
+#define DMA1_Channel2_IRQHandler  DMA1_Channel2_3_IRQHandler
+#elif defined(STM32F0xx)
+#if defined(STM32F091xC) || defined(STM32F098xx)
+#define DMA1_Channel1_IRQn        DMA1_Ch1_IRQn
+#define DMA1_Channel2_IRQn        DMA1_Ch2_3_DMA2_Ch1_2_IRQn
+#define DMA1_Channel3_IRQn        DMA1_Ch2_3_DMA2_Ch1_2_IRQn
+#define DMA2_Channel1_IRQn        DMA1_Ch2_3_DMA2_Ch1_2_IRQn
+#define DMA2_Channel2_IRQn        DMA1_Ch2_3_DMA2_Ch1_2_IRQn
+#define DMA1_Channel4_IRQn        DMA1_Ch4_7_DMA2_Ch3_5_IRQn
+#define DMA1_Channel5_IRQn        DMA1_Ch4_7_DMA2_Ch3_5_IRQn
+#define DMA1_Channel6_IRQn        DMA1_Ch4_7_DMA2_Ch3_5_IRQn
+#define DMA1_Channel7_IRQn        DMA1_Ch4_7_DMA2_Ch3_5_IRQn
+#define DMA2_Channel3_IRQn        DMA1_Ch4_7_DMA2_Ch3_5_IRQn
+#define DMA2_Channel4_IRQn        DMA1_Ch4_7_DMA2_Ch3_5_IRQn
+#define DMA2_Channel5_IRQn        DMA1_Ch4_7_DMA2_Ch3_5_IRQn
+#define DMA1_Channel1_IRQHandler  DMA1_Ch1_IRQHandler
+#define DMA1_Channel2_IRQHandler  DMA1_Ch2_3_DMA2_Ch1_2_IRQHandler
+#define DMA1_Channel4_IRQHandler  DMA1_Ch4_7_DMA2_Ch3_5_IRQHandler
+#else
+#define DMA1_Channel2_IRQn        DMA1_Channel2_3_IRQn
+#define DMA1_Channel3_IRQn        DMA1_Channel2_3_IRQn
+#define DMA1_Channel2_IRQHandler  DMA1_Channel2_3_IRQHandler
+#if defined(DMA1_Channel6_BASE)
+#define DMA1_Channel4_IRQn        DMA1_Channel4_5_6_7_IRQn
+#define DMA1_Channel5_IRQn        DMA1_Channel4_5_6_7_IRQn
+#define DMA1_Channel6_IRQn        DMA1_Channel4_5_6_7_IRQn
+#define DMA1_Channel7_IRQn        DMA1_Channel4_5_6_7_IRQn
+#define DMA1_Channel4_IRQHandler  DMA1_Channel4_5_6_7_IRQHandler
+#else
+#define DMA1_Channel4_IRQn        DMA1_Channel4_5_IRQn
+#define DMA1_Channel5_IRQn        DMA1_Channel4_5_IRQn
+#define DMA1_Channel4_IRQHandler  DMA1_Channel4_5_IRQHandler
+#endif
+#endif /* STM32F091xC || STM32F098xx */
+#elif defined(STM32G0xx)
+#define DMA1_Channel2_IRQn        DMA1_Channel2_3_IRQn
+#define DMA1_Channel3_IRQn        DMA1_Channel2_3_IRQn
+#define DMA1_Channel2_IRQHandler  DMA1_Channel2_3_IRQHandler
+#if defined(DMA2_BASE)
+#define DMA1_Channel4_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA1_Channel5_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA1_Channel6_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA1_Channel7_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA2_Channel1_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA2_Channel2_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA2_Channel3_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA2_Channel4_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA2_Channel5_IRQn        DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQn
+#define DMA1_Channel4_IRQHandler  DMA1_Ch4_7_DMA2_Ch1_5_DMAMUX1_OVR_IRQHandler
+#elif defined(DMA1_Channel6_BASE)
+#define DMA1_Channel4_IRQn        DMA1_Ch4_7_DMAMUX1_OVR_IRQn
+#define DMA1_Channel5_IRQn        DMA1_Ch4_7_DMAMUX1_OVR_IRQn
+#define DMA1_Channel6_IRQn        DMA1_Ch4_7_DMAMUX1_OVR_IRQn
+#define DMA1_Channel7_IRQn        DMA1_Ch4_7_DMAMUX1_OVR_IRQn
+#define DMA1_Channel4_IRQHandler  DMA1_Ch4_7_DMAMUX1_OVR_IRQHandler
+#else
+#define DMA1_Channel4_IRQn        DMA1_Ch4_5_DMAMUX1_OVR_IRQn
+#define DMA1_Channel5_IRQn        DMA1_Ch4_5_DMAMUX1_OVR_IRQn
+#define DMA1_Channel4_IRQHandler  DMA1_Ch4_5_DMAMUX1_OVR_IRQHandler
+#endif
+#elif defined(STM32L0xx)
+#define DMA1_Channel2_IRQn        DMA1_Channel2_3_IRQn
+#define DMA1_Channel3_IRQn        DMA1_Channel2_3_IRQn
+#define DMA1_Channel2_IRQHandler  DMA1_Channel2_3_IRQHandler
+#if defined(DMA1_Channel6_BASE)
+#define DMA1_Channel4_IRQn        DMA1_Channel4_5_6_7_IRQn
+#define DMA1_Channel5_IRQn        DMA1_Channel4_5_6_7_IRQn
+#define DMA1_Channel6_IRQn        DMA1_Channel4_5_6_7_IRQn
+#define DMA1_Channel7_IRQn        DMA1_Channel4_5_6_7_IRQn
+#define DMA1_Channel4_IRQHandler  DMA1_Channel4_5_6_7_IRQHandler
+#else
+#define DMA1_Channel4_IRQn        DMA1_Channel4_5_IRQn
+#define DMA1_Channel5_IRQn        DMA1_Channel4_5_IRQn
+#define DMA1_Channel4_IRQHandler  DMA1_Channel4_5_IRQHandler
+#endif
+#elif defined(STM32F1xx) && defined(DMA2_BASE)
+#if !defined(STM32F105xC) && !defined(STM32F107xC)
+#define DMA2_Channel4_IRQn        DMA2_Channel4_5_IRQn
+#define DMA2_Channel5_IRQn        DMA2_Channel4_5_IRQn
+#define DMA2_Channel4_IRQHandler  DMA2_Channel4_5_IRQHandler
+#endif
+#endif
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief  Clean data cache lines of a buffer before a memory to peripheral
+  *         transfer (Cortex-M7 only, NOP otherwise)
+  * @param  addr : buffer address
+  * @param  size : buffer size in bytes
+  * @retval None
+  */
+static inline void dma_clean_dcache(const void *addr, uint32_t size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  uint32_t start = (uint32_t)addr & ~(DMA_DCACHE_LINE_SIZE - 1U);
+  SCB_CleanDCache_by_Addr((uint32_t *)start, (int32_t)((uint32_t)addr + size - start));
+#else
+  UNUSED(addr);
+  UNUSED(size);
+#endif
+}
+
+/**
+  * @brief  Invalidate data cache lines of a buffer after a peripheral to
+  *         memory transfer (Cortex-M7 only, NOP otherwise)
+  * @note   Buffer should be aligned on cache lines (32 bytes) as the CPU
+  *         writes sharing its first and last lines would be lost.
+  * @param  addr : buffer address
+  * @param  size : buffer size in bytes
+  * @retval None
+  */
+static inline void dma_invalidate_dcache(const void *addr, uint32_t size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  uint32_t start = (uint32_t)addr & ~(DMA_DCACHE_LINE_SIZE - 1U);
+  SCB_InvalidateDCache_by_Addr((uint32_t *)start, (int32_t)((uint32_t)addr + size - start));
+#else
+  UNUSED(addr);
+  UNUSED(size);
+#endif
+}
+
+/**
+  * @brief  Enable or disable the memory address increment of a DMA channel,
+  *         to send (or receive) the same dummy data for the whole transfer
+  * @note   Channel must be disabled
+  * @param  hdma : DMA handle
+  * @param  inc : true to increment the memory address
+  * @retval None
+  */
+static inline void dma_set_mem_inc(DMA_HandleTypeDef *hdma, bool inc)
+{
+  dma_channel_t *channel = (dma_channel_t *)hdma->Instance;
+
+#if defined(DMA_SxCR_MINC)
+  if (inc) {
+    channel->CR |= DMA_SxCR_MINC;
+  } else {
+    channel->CR &= ~DMA_SxCR_MINC;
+  }
+#else
+  if (inc) {
+    channel->CCR |= DMA_CCR_MINC;
+  } else {
+    channel->CCR &= ~DMA_CCR_MINC;
+  }
+#endif
+}
+
+/**
+  * @brief  Set the data size of a DMA channel
+  * @note   Channel must be disabled
+  * @param  hdma : DMA handle
+  * @param  datasize : data size in bytes (1, 2 or 4)
+  * @retval None
+  */
+static inline void dma_set_data_size(DMA_HandleTypeDef *hdma, uint32_t datasize)
+{
+  dma_channel_t *channel = (dma_channel_t *)hdma->Instance;
+  uint32_t size = (datasize == 4) ? 2U : ((datasize == 2) ? 1U : 0U);
+
+#if defined(DMA_SxCR_MINC)
+  MODIFY_REG(channel->CR, DMA_SxCR_PSIZE | DMA_SxCR_MSIZE,
+             (size << DMA_SxCR_PSIZE_Pos) | (size << DMA_SxCR_MSIZE_Pos));
+#else
+  MODIFY_REG(channel->CCR, DMA_CCR_PSIZE | DMA_CCR_MSIZE,
+             (size << DMA_CCR_PSIZE_Pos) | (size << DMA_CCR_MSIZE_Pos));
+#endif
+}
+
+IRQn_Type dma_get_irqn(dma_channel_t *instance);
+bool dma_init(DMA_HandleTypeDef *hdma, dma_channel_t *instance, uint32_t request,
+              uint32_t direction, uint32_t mode, uint32_t datasize);
+void dma_deinit(DMA_HandleTypeDef *hdma);
+
+#endif /* HAL_DMA_MODULE_ENABLED && !HAL_DMA_MODULE_ONLY */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DMA_H */
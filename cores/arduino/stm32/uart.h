@@ -40,6 +40,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32_def.h"
 #include "PinNames.h"
+#include "dma.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -56,9 +57,32 @@ extern "C" {
 #define UART_IRQ_SUBPRIO    0
 #endif
 
+/* Number of received frames queued in frame mode */
+#ifndef UART_FRAME_QUEUE_SIZE
+#define UART_FRAME_QUEUE_SIZE 4
+#endif
+
+/* DMA not supported by this series: fall back to interrupt mode */
+#if defined(UART_DMA_ENABLED) && !defined(DMA_WRAPPER_ENABLED)
+#undef UART_DMA_ENABLED
+#endif
+
 /* Exported types ------------------------------------------------------------*/
 typedef struct serial_s serial_t;
 
+/* Link statistics, updated from the interrupt handlers */
+typedef struct {
+  uint32_t rx_bytes;        /* Bytes received (stored or dropped) */
+  uint32_t tx_bytes;        /* Bytes transmitted */
+  uint32_t rx_overflows;    /* Bytes dropped, rx buffer full */
+  uint32_t overrun_errors;  /* ORE: data lost by the U(S)ART */
+  uint32_t framing_errors;  /* FE */
+  uint32_t parity_errors;   /* PE */
+  uint32_t noise_errors;    /* NE */
+  uint32_t tx_stall_us;     /* Time spent waiting for room in the tx buffer */
+  uint16_t rx_peak;         /* Max number of bytes pending in the rx buffer */
+} serial_stats_t;
+
 struct serial_s {
   /*  The 1st 2 members USART_TypeDef *uart
    *  and UART_HandleTypeDef handle should
@@ -78,11 +102,43 @@ struct serial_s {
   uint8_t recv;
   uint8_t *rx_buff;
   uint8_t *tx_buff;
-  uint16_t rx_tail;
-  uint16_t tx_head;
+  uint16_t rx_buff_size;
+  uint16_t tx_buff_size;
+  /* Each index is only written by one side (thread or interrupt) */
+  volatile uint16_t rx_tail;
+  volatile uint16_t tx_head;
   volatile uint16_t rx_head;
   volatile uint16_t tx_tail;
   size_t tx_size;
+  serial_stats_t stats;
+  /* Frame mode: rx_head at the end of the received frames and their date */
+  uint8_t frame_mode;
+  volatile uint8_t frame_head;
+  volatile uint8_t frame_tail;
+  uint16_t frame_start;
+  uint16_t frame_end[UART_FRAME_QUEUE_SIZE];
+  uint32_t frame_time[UART_FRAME_QUEUE_SIZE];
+  void (*frame_callback)(uint16_t, uint32_t);
+#if defined(UART_DMA_ENABLED)
+  /* RX DMA channel requested, NULL to use interrupt mode */
+  dma_channel_t *dma_rx;
+  uint32_t dma_rx_request;
+  /* Size of the circular DMA reception, 0 if not running */
+  uint16_t rx_dma_size;
+  /* Unread data overwritten by the DMA, rx_tail is moved by the reader */
+  volatile uint8_t rx_dma_lapped;
+  DMA_HandleTypeDef hdma_rx;
+  /* TX DMA channel requested, NULL to use interrupt mode */
+  dma_channel_t *dma_tx;
+  uint32_t dma_tx_request;
+  DMA_HandleTypeDef hdma_tx;
+#endif
+#if defined(UART_LL_IRQ)
+  /* Transfers handled by the lean interrupt handler */
+  uint8_t ll_rx;
+  volatile uint8_t ll_tx;
+  uint8_t rx_mask;
+#endif
 };
 
 /* Exported constants --------------------------------------------------------*/
@@ -90,6 +146,24 @@ struct serial_s {
 #define TX_TIMEOUT  1000
 #endif
 
+/* End of frame detection */
+#define UART_FRAME_NONE     0
+#define UART_FRAME_IDLE     1 /* Idle line during one character */
+#define UART_FRAME_TIMEOUT  2 /* Receiver timeout */
+
+#if defined(USART_CR1_FIFOEN)
+/* FIFO mode thresholds and receiver timeout (in bit duration) */
+#ifndef UART_FIFO_RX_THRESHOLD
+#define UART_FIFO_RX_THRESHOLD  UART_RXFIFO_THRESHOLD_1_2
+#endif
+#ifndef UART_FIFO_TX_THRESHOLD
+#define UART_FIFO_TX_THRESHOLD  UART_TXFIFO_THRESHOLD_1_2
+#endif
+#ifndef UART_FIFO_RX_TIMEOUT
+#define UART_FIFO_RX_TIMEOUT    20
+#endif
+#endif
+
 #if !defined(RCC_USART1CLKSOURCE_HSI)
 /* Some series like C0 have 2 derivated clock from HSI: HSIKER (for peripherals)
  * and HSISYS (for system clock). But each have a dedicated prescaler.
@@ -233,6 +307,20 @@ struct serial_s {
 #endif
 
 /* Exported macro ------------------------------------------------------------*/
+/**
+  * @brief  Record the rx buffer occupancy, to be called when rx_head moves
+  * @param  obj : pointer to serial_t structure
+  * @retval None
+  */
+static inline void serial_stats_rx_peak(serial_t *obj)
+{
+  uint16_t count = (obj->rx_head >= obj->rx_tail) ? obj->rx_head - obj->rx_tail :
+                   obj->rx_buff_size + obj->rx_head - obj->rx_tail;
+  if (count > obj->stats.rx_peak) {
+    obj->stats.rx_peak = count;
+  }
+}
+
 /* Exported functions ------------------------------------------------------- */
 void uart_init(serial_t *obj, uint32_t baudrate, uint32_t databits, uint32_t parity, uint32_t stopbits);
 void uart_deinit(serial_t *obj);
@@ -242,6 +330,14 @@ void uart_config_lowpower(serial_t *obj);
 int uart_getc(serial_t *obj, unsigned char *c);
 void uart_attach_rx_callback(serial_t *obj, void (*callback)(serial_t *));
 void uart_attach_tx_callback(serial_t *obj, int (*callback)(serial_t *), size_t size);
+#if defined(UART_DMA_ENABLED)
+bool uart_attach_rx_dma(serial_t *obj, uint16_t size);
+bool uart_attach_tx_dma(serial_t *obj);
+#endif
+#if defined(USART_CR1_FIFOEN)
+bool uart_enable_fifo(serial_t *obj);
+#endif
+uint8_t uart_enable_frame(serial_t *obj, uint32_t gap);
 
 uint8_t serial_tx_active(serial_t *obj);
 uint8_t serial_rx_active(serial_t *obj);
@@ -250,6 +346,7 @@ void uart_enable_tx(serial_t *obj);
 void uart_enable_rx(serial_t *obj);
 
 size_t uart_debug_write(uint8_t *data, uint32_t size);
+uint32_t uart_debug_dropped(void);
 
 #endif /* HAL_UART_MODULE_ENABLED  && !HAL_UART_MODULE_ONLY */
 #ifdef __cplusplus
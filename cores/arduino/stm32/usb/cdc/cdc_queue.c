@@ -45,6 +45,7 @@ void CDC_TransmitQueue_Init(CDC_TransmitQueue_TypeDef *queue)
 {
   queue->read = 0;
   queue->write = 0;
+  queue->write_reserved = 0;
 }
 
 // Determine size, available for write in queue
@@ -95,6 +96,40 @@ void CDC_TransmitQueue_CommitRead(CDC_TransmitQueue_TypeDef *queue)
                 CDC_TRANSMIT_QUEUE_BUFFER_SIZE;
 }
 
+// Get the largest flat free block of queue, to be filled in place.
+// TS: only called from the main thread, read position does not move
+// while the queue is empty.
+uint8_t *CDC_TransmitQueue_ReserveBlock(CDC_TransmitQueue_TypeDef *queue,
+                                        uint16_t *size)
+{
+  if (queue->write == queue->read) {
+    // Nothing to send, restart from the start of the buffer
+    queue->read = 0;
+    queue->write = 0;
+  }
+  if (queue->write >= queue->read) {
+    *size = CDC_TRANSMIT_QUEUE_BUFFER_SIZE - queue->write - ((queue->read == 0) ? 1 : 0);
+  } else {
+    *size = queue->read - queue->write - 1;
+  }
+  queue->write_reserved = *size;
+  return &queue->buffer[queue->write];
+}
+
+// Add size bytes of the reserved block to the queue, at most its size.
+// Returns the number of bytes added, the block is released.
+uint16_t CDC_TransmitQueue_CommitWrite(CDC_TransmitQueue_TypeDef *queue,
+                                       uint16_t size)
+{
+  if (size > queue->write_reserved) {
+    size = queue->write_reserved;
+  }
+  queue->write_reserved = 0;
+  queue->write = (uint16_t)((queue->write + size) %
+                            CDC_TRANSMIT_QUEUE_BUFFER_SIZE);
+  return size;
+}
+
 // Initialize read and write position of queue.
 void CDC_ReceiveQueue_Init(CDC_ReceiveQueue_TypeDef *queue)
 {
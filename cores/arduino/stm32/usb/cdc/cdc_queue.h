@@ -67,6 +67,8 @@ typedef struct {
   volatile uint16_t write;
   volatile uint16_t read;
   volatile uint16_t reserved;
+  /* Size of the block reserved by the main thread, to be committed */
+  uint16_t write_reserved;
 } CDC_TransmitQueue_TypeDef;
 
 typedef struct {
@@ -82,6 +84,8 @@ int CDC_TransmitQueue_ReadSize(CDC_TransmitQueue_TypeDef *queue);
 void CDC_TransmitQueue_Enqueue(CDC_TransmitQueue_TypeDef *queue, const uint8_t *buffer, uint32_t size);
 uint8_t *CDC_TransmitQueue_ReadBlock(CDC_TransmitQueue_TypeDef *queue, uint16_t *size);
 void CDC_TransmitQueue_CommitRead(CDC_TransmitQueue_TypeDef *queue);
+uint8_t *CDC_TransmitQueue_ReserveBlock(CDC_TransmitQueue_TypeDef *queue, uint16_t *size);
+uint16_t CDC_TransmitQueue_CommitWrite(CDC_TransmitQueue_TypeDef *queue, uint16_t size);
 
 void CDC_ReceiveQueue_Init(CDC_ReceiveQueue_TypeDef *queue);
 int CDC_ReceiveQueue_ReadSize(CDC_ReceiveQueue_TypeDef *queue);
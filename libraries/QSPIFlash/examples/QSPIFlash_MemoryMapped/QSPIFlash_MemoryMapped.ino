@@ -0,0 +1,86 @@
+/*
+  QSPI flash memory-mapped mode
+
+  Stores a lookup table in the external flash, then reads it back with
+  indirect quad reads and straight from the address space in memory-mapped
+  mode, measuring both.
+
+  The default pins are the ones of the MX25R6435F memory of the
+  B-L475E-IOT01A and B-L4S5I-IOT01A boards. HAL_QSPI_MODULE_ENABLED (or
+  HAL_OSPI_MODULE_ENABLED) has to be defined, in hal_conf_extra.h.
+
+  With QSPI_DMA_ENABLED defined, the indirect transfers can use a DMA
+  channel set with flash.setDMA() before flash.begin().
+
+  This example code is in the public domain.
+*/
+
+#include <QSPIFlash.h>
+
+#if defined(MX25R6435F_D0)
+QSPIFlash flash(MX25R6435F_D0, MX25R6435F_D1, MX25R6435F_D2, MX25R6435F_D3,
+                MX25R6435F_SCLK, MX25R6435F_SSEL);
+#else
+// Set the pins connected to the memory
+QSPIFlash flash(PE12, PE13, PE14, PE15, PE10, PE11);
+#endif
+
+#define TABLE_ADDRESS 0
+#define TABLE_SIZE    1024
+
+static uint16_t table[TABLE_SIZE];
+static uint16_t buffer[TABLE_SIZE];
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+
+  if (!flash.begin()) {
+    Serial.println("No flash memory found");
+    while (1);
+  }
+  Serial.print("JEDEC ID: ");
+  Serial.print(flash.jedecId(), HEX);
+  Serial.print(", size: ");
+  Serial.print(flash.size() / 1024);
+  Serial.println(" KB");
+
+  // Sine lookup table
+  for (int i = 0; i < TABLE_SIZE; i++) {
+    table[i] = 32767 + 32767 * sin(2 * PI * i / TABLE_SIZE);
+  }
+  flash.eraseSector(TABLE_ADDRESS);
+  flash.write(TABLE_ADDRESS, table, sizeof(table));
+
+  uint32_t start = micros();
+  flash.read(TABLE_ADDRESS, buffer, sizeof(buffer));
+  uint32_t elapsed = micros() - start;
+  Serial.print("Indirect read: ");
+  Serial.print(elapsed);
+  Serial.println(" us");
+  Serial.println(memcmp(table, buffer, sizeof(table)) == 0 ? "Data OK" : "Data mismatch");
+
+  const uint8_t *memory = flash.enableMemoryMapped();
+  if (memory == NULL) {
+    Serial.println("Memory-mapped mode failed");
+    while (1);
+  }
+  // The table is used in place
+  const uint16_t *mapped = (const uint16_t *)(memory + TABLE_ADDRESS);
+  uint32_t sum = 0;
+  start = micros();
+  for (int i = 0; i < TABLE_SIZE; i++) {
+    sum += mapped[i];
+  }
+  elapsed = micros() - start;
+  Serial.print("Memory-mapped read: ");
+  Serial.print(elapsed);
+  Serial.print(" us, sum ");
+  Serial.println(sum);
+  Serial.println(memcmp(table, mapped, sizeof(table)) == 0 ? "Data OK" : "Data mismatch");
+}
+
+void loop()
+{
+}
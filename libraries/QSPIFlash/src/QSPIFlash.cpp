@@ -0,0 +1,439 @@
+/*
+ * Quad SPI flash library for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "QSPIFlash.h"
+
+/* Serial NOR flash commands */
+#define CMD_WRITE_ENABLE          0x06
+#define CMD_READ_STATUS           0x05
+#define CMD_READ_STATUS2          0x35
+#define CMD_WRITE_STATUS          0x01
+#define CMD_READ_ID               0x9F
+#define CMD_RESET_ENABLE          0x66
+#define CMD_RESET                 0x99
+#define CMD_QUAD_READ             0xEB  /* 1-4-4 */
+#define CMD_QUAD_READ_4B          0xEC
+#define CMD_QUAD_PROGRAM          0x32  /* 1-1-4 */
+#define CMD_QUAD_PROGRAM_4B       0x34
+#define CMD_QUAD_IO_PROGRAM       0x38  /* 1-4-4 */
+#define CMD_QUAD_IO_PROGRAM_4B    0x3E
+#define CMD_SECTOR_ERASE          0x20
+#define CMD_SECTOR_ERASE_4B       0x21
+#define CMD_BLOCK_ERASE           0xD8
+#define CMD_BLOCK_ERASE_4B        0xDC
+#define CMD_CHIP_ERASE            0xC7
+
+#define STATUS_WIP                0x01
+#define STATUS_WEL                0x02
+
+/* JEDEC manufacturer IDs */
+#define MANUFACTURER_MICRON       0x20
+#define MANUFACTURER_ISSI         0x9D
+#define MANUFACTURER_MACRONIX     0xC2
+
+/* Maximum durations in ms */
+#define PROGRAM_TIMEOUT           10
+#define SECTOR_ERASE_TIMEOUT      1000
+#define BLOCK_ERASE_TIMEOUT       4000
+#define CHIP_ERASE_TIMEOUT        400000
+
+/**
+  * @brief  Invalidate the data cache lines of a range of the memory-mapped
+  *         region, once modified (Cortex-M7 only, NOP otherwise)
+  * @param  base: start of the memory-mapped region.
+  * @param  address: start of the range in the memory.
+  * @param  count: size of the range.
+  */
+static void invalidateCache(const uint8_t *base, uint32_t address, uint32_t count)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  uint32_t start = ((uint32_t)base + address) & ~31UL;
+  SCB_InvalidateDCache_by_Addr((uint32_t *)start, (int32_t)((uint32_t)base + address + count - start));
+#else
+  UNUSED(base);
+  UNUSED(address);
+  UNUSED(count);
+#endif
+}
+
+/**
+  * @brief  Quad SPI flash memory.
+  * @param  data0..data3: data pins (IO0 to IO3).
+  * @param  sclk: clock pin.
+  * @param  ssel: chip select pin.
+  */
+QSPIFlash::QSPIFlash(uint32_t data0, uint32_t data1, uint32_t data2, uint32_t data3,
+                     uint32_t sclk, uint32_t ssel)
+{
+  memset(&_qspi, 0, sizeof(_qspi));
+  _qspi.pin_data0 = digitalPinToPinName(data0);
+  _qspi.pin_data1 = digitalPinToPinName(data1);
+  _qspi.pin_data2 = digitalPinToPinName(data2);
+  _qspi.pin_data3 = digitalPinToPinName(data3);
+  _qspi.pin_sclk = digitalPinToPinName(sclk);
+  _qspi.pin_ssel = digitalPinToPinName(ssel);
+#if defined(QSPI_DMA_ENABLED)
+  _qspi.dma_threshold = QSPI_DMA_THRESHOLD;
+#endif
+}
+
+/**
+  * @brief  Initialize the peripheral, identify the memory by its JEDEC ID
+  *         and enable its quad mode.
+  * @param  clock: clock speed in Hz, the closest one below is used.
+  * @return true if a memory is found.
+  */
+bool QSPIFlash::begin(uint32_t clock)
+{
+  uint8_t id[3];
+  uint32_t size_bits;
+
+  _jedecId = 0;
+  _size = 0;
+  _mapped = false;
+
+  // Size is unknown: use the largest
+  if (!qspi_init(&_qspi, clock, 0)) {
+    return false;
+  }
+  // The memory may have been left busy by a previous run
+  command(CMD_RESET_ENABLE);
+  command(CMD_RESET);
+  delayMicroseconds(100);
+
+  if (!command(CMD_READ_ID, NULL, id, sizeof(id)) || (id[0] == 0x00) || (id[0] == 0xFF)) {
+    end();
+    return false;
+  }
+  // Capacity is 2^n bytes, above 256 Mbit most vendors continue from 0x20
+  size_bits = (id[2] >= 0x20) ? (id[2] - 6U) : id[2];
+  if ((size_bits < 16) || (size_bits > 28)) {
+    end();
+    return false;
+  }
+  _jedecId = ((uint32_t)id[0] << 16) | ((uint32_t)id[1] << 8) | id[2];
+  _size = 1UL << size_bits;
+  qspi_init(&_qspi, clock, _size);
+
+  // Beyond 16 MB, the 4-byte address commands are used
+  _addressSize = (_size > 0x1000000UL) ? 4 : 3;
+  _readDummy = 4;
+  if (id[0] == MANUFACTURER_MACRONIX) {
+    // Page program with quad address
+    _programCmd = (_addressSize == 4) ? CMD_QUAD_IO_PROGRAM_4B : CMD_QUAD_IO_PROGRAM;
+    _programAddressLines = 4;
+  } else {
+    _programCmd = (_addressSize == 4) ? CMD_QUAD_PROGRAM_4B : CMD_QUAD_PROGRAM;
+    _programAddressLines = 1;
+    if (id[0] == MANUFACTURER_MICRON) {
+      // 10 cycles, mode byte included
+      _readDummy = 8;
+    }
+  }
+
+  if (!quadEnable()) {
+    end();
+    return false;
+  }
+  return true;
+}
+
+/**
+  * @brief  Release the peripheral and its pins.
+  */
+void QSPIFlash::end(void)
+{
+  qspi_deinit(&_qspi);
+  _size = 0;
+  _mapped = false;
+}
+
+/**
+  * @brief  Read data in quad mode.
+  *         Data are read by blocks of 64 KB, each one with its own timeout:
+  *         even at the slowest clock, a block is read in less than
+  *         QSPI_TIMEOUT_MS.
+  * @param  address: address in the memory.
+  * @param  buf: data read.
+  * @param  count: number of bytes to read.
+  * @return true on success.
+  */
+bool QSPIFlash::read(uint32_t address, void *buf, uint32_t count)
+{
+  uint8_t *data = (uint8_t *)buf;
+  qspi_command_t cmd;
+  bool success = true;
+
+  if ((buf == NULL) || (address >= _size) || (count > (_size - address))) {
+    return false;
+  }
+  while (success && (count != 0)) {
+    uint32_t chunk = (count > QSPI_FLASH_BLOCK_SIZE) ? QSPI_FLASH_BLOCK_SIZE : count;
+
+    readCommand(&cmd, address);
+    success = (qspi_command(&_qspi, &cmd, NULL, data, chunk, QSPI_TIMEOUT_MS) == QSPI_OK);
+    address += chunk;
+    data += chunk;
+    count -= chunk;
+  }
+  return finish(success);
+}
+
+/**
+  * @brief  Program data in quad mode, the memory must be erased before.
+  *         Data are split at the page boundaries.
+  * @param  address: address in the memory.
+  * @param  buf: data to program.
+  * @param  count: number of bytes to program.
+  * @return true on success.
+  */
+bool QSPIFlash::write(uint32_t address, const void *buf, uint32_t count)
+{
+  const uint8_t *data = (const uint8_t *)buf;
+  uint32_t start = address;
+  uint32_t remaining = count;
+  qspi_command_t cmd = {};
+  bool success = true;
+
+  if ((buf == NULL) || (address >= _size) || (count > (_size - address))) {
+    return false;
+  }
+
+  cmd.instruction = _programCmd;
+  cmd.instruction_lines = 1;
+  cmd.address_size = _addressSize;
+  cmd.address_lines = _programAddressLines;
+  cmd.data_lines = 4;
+  while (success && (remaining != 0)) {
+    uint32_t chunk = QSPI_FLASH_PAGE_SIZE - (address % QSPI_FLASH_PAGE_SIZE);
+
+    if (chunk > remaining) {
+      chunk = remaining;
+    }
+    cmd.address = address;
+    success = writeEnable() &&
+              (qspi_command(&_qspi, &cmd, data, NULL, chunk, QSPI_TIMEOUT_MS) == QSPI_OK) &&
+              waitReady(PROGRAM_TIMEOUT);
+    address += chunk;
+    data += chunk;
+    remaining -= chunk;
+  }
+  invalidateCache(qspi_memory_base(&_qspi), start, count);
+  return finish(success);
+}
+
+/**
+  * @brief  Erase the 4 KB sector holding the address.
+  */
+bool QSPIFlash::eraseSector(uint32_t address)
+{
+  return erase((_addressSize == 4) ? CMD_SECTOR_ERASE_4B : CMD_SECTOR_ERASE,
+               address & ~(QSPI_FLASH_SECTOR_SIZE - 1UL), SECTOR_ERASE_TIMEOUT);
+}
+
+/**
+  * @brief  Erase the 64 KB block holding the address.
+  */
+bool QSPIFlash::eraseBlock(uint32_t address)
+{
+  return erase((_addressSize == 4) ? CMD_BLOCK_ERASE_4B : CMD_BLOCK_ERASE,
+               address & ~(QSPI_FLASH_BLOCK_SIZE - 1UL), BLOCK_ERASE_TIMEOUT);
+}
+
+/**
+  * @brief  Erase the whole memory, this can take minutes.
+  */
+bool QSPIFlash::eraseChip(void)
+{
+  bool success;
+
+  if (_size == 0) {
+    return false;
+  }
+  success = writeEnable() && command(CMD_CHIP_ERASE) && waitReady(CHIP_ERASE_TIMEOUT);
+  invalidateCache(qspi_memory_base(&_qspi), 0, _size);
+  return finish(success);
+}
+
+/**
+  * @brief  Enter the memory-mapped mode: the memory is read with quad
+  *         commands when accessed through the address space.
+  * @return pointer to the byte 0 of the memory, NULL on error.
+  */
+const uint8_t *QSPIFlash::enableMemoryMapped(void)
+{
+  qspi_command_t cmd;
+
+  if (_size == 0) {
+    return NULL;
+  }
+  readCommand(&cmd, 0);
+  _mapped = (qspi_memory_mapped(&_qspi, &cmd) == QSPI_OK);
+  return _mapped ? qspi_memory_base(&_qspi) : NULL;
+}
+
+/**
+  * @brief  Leave the memory-mapped mode.
+  */
+void QSPIFlash::disableMemoryMapped(void)
+{
+  _mapped = false;
+  qspi_abort(&_qspi);
+}
+
+/**
+  * @brief  Send a single line command.
+  * @param  instruction: command code.
+  * @param  tx_buf: data to send, or NULL.
+  * @param  rx_buf: data to receive, or NULL.
+  * @param  count: number of data bytes.
+  * @return true on success.
+  */
+bool QSPIFlash::command(uint8_t instruction, const void *tx_buf, void *rx_buf, uint32_t count)
+{
+  qspi_command_t cmd = {};
+
+  cmd.instruction = instruction;
+  cmd.instruction_lines = 1;
+  cmd.data_lines = 1;
+  return qspi_command(&_qspi, &cmd, (const uint8_t *)tx_buf, (uint8_t *)rx_buf, count,
+                      QSPI_TIMEOUT_MS) == QSPI_OK;
+}
+
+/**
+  * @brief  Enable the write/erase operations, until the end of the next one.
+  */
+bool QSPIFlash::writeEnable(void)
+{
+  qspi_command_t cmd = {};
+
+  cmd.instruction = CMD_READ_STATUS;
+  cmd.instruction_lines = 1;
+  cmd.data_lines = 1;
+  return command(CMD_WRITE_ENABLE) &&
+         (qspi_poll_status(&_qspi, &cmd, STATUS_WEL, STATUS_WEL, QSPI_TIMEOUT_MS) == QSPI_OK);
+}
+
+/**
+  * @brief  Wait for the end of a write/erase operation.
+  * @param  timeout: maximum duration in ms.
+  */
+bool QSPIFlash::waitReady(uint32_t timeout)
+{
+  qspi_command_t cmd = {};
+
+  cmd.instruction = CMD_READ_STATUS;
+  cmd.instruction_lines = 1;
+  cmd.data_lines = 1;
+  return qspi_poll_status(&_qspi, &cmd, 0, STATUS_WIP, timeout) == QSPI_OK;
+}
+
+/**
+  * @brief  Erase a sector or a block.
+  * @param  instruction: erase command code.
+  * @param  address: address of the sector or block.
+  * @param  timeout: maximum duration in ms.
+  */
+bool QSPIFlash::erase(uint8_t instruction, uint32_t address, uint32_t timeout)
+{
+  qspi_command_t cmd = {};
+  bool success;
+
+  if (address >= _size) {
+    return false;
+  }
+  cmd.instruction = instruction;
+  cmd.instruction_lines = 1;
+  cmd.address = address;
+  cmd.address_size = _addressSize;
+  cmd.address_lines = 1;
+  success = writeEnable() &&
+            (qspi_command(&_qspi, &cmd, NULL, NULL, 0, QSPI_TIMEOUT_MS) == QSPI_OK) &&
+            waitReady(timeout);
+  invalidateCache(qspi_memory_base(&_qspi), address,
+                  (instruction == CMD_SECTOR_ERASE) || (instruction == CMD_SECTOR_ERASE_4B) ?
+                  QSPI_FLASH_SECTOR_SIZE : QSPI_FLASH_BLOCK_SIZE);
+  return finish(success);
+}
+
+/**
+  * @brief  Set the quad enable bit of the memory, required by the quad
+  *         commands. Its location depends on the manufacturer.
+  */
+bool QSPIFlash::quadEnable(void)
+{
+  uint8_t status[2];
+
+  switch (_jedecId >> 16) {
+    case MANUFACTURER_MICRON:
+      // Quad commands always enabled
+      return true;
+    case MANUFACTURER_MACRONIX:
+    case MANUFACTURER_ISSI:
+      // Bit 6 of the status register
+      if (!command(CMD_READ_STATUS, NULL, status, 1)) {
+        return false;
+      }
+      if (status[0] & 0x40) {
+        return true;
+      }
+      status[0] |= 0x40;
+      return writeEnable() && command(CMD_WRITE_STATUS, status, NULL, 1) &&
+             waitReady(SECTOR_ERASE_TIMEOUT);
+    default:
+      // Winbond, GigaDevice, Spansion...: bit 1 of the status register 2,
+      // both registers are written
+      if (!command(CMD_READ_STATUS, NULL, &status[0], 1) ||
+          !command(CMD_READ_STATUS2, NULL, &status[1], 1)) {
+        return false;
+      }
+      if (status[1] & 0x02) {
+        return true;
+      }
+      status[1] |= 0x02;
+      return writeEnable() && command(CMD_WRITE_STATUS, status, NULL, 2) &&
+             waitReady(SECTOR_ERASE_TIMEOUT);
+  }
+}
+
+/**
+  * @brief  Fill the quad I/O read command, used in indirect and memory-mapped
+  *         modes. The mode byte 0xFF keeps the memory out of continuous read.
+  * @param  cmd: command to fill.
+  * @param  address: address in the memory.
+  */
+void QSPIFlash::readCommand(qspi_command_t *cmd, uint32_t address)
+{
+  cmd->instruction = (_addressSize == 4) ? CMD_QUAD_READ_4B : CMD_QUAD_READ;
+  cmd->instruction_lines = 1;
+  cmd->address = address;
+  cmd->address_size = _addressSize;
+  cmd->address_lines = 4;
+  cmd->alternate = 0xFF;
+  cmd->alternate_lines = 4;
+  cmd->dummy_cycles = _readDummy;
+  cmd->data_lines = 4;
+}
+
+/**
+  * @brief  End of an indirect operation: enter the memory-mapped mode again
+  *         if it was enabled.
+  * @param  success: status of the operation.
+  * @return the status.
+  */
+bool QSPIFlash::finish(bool success)
+{
+  qspi_command_t cmd;
+
+  if (_mapped) {
+    readCommand(&cmd, 0);
+    _mapped = (qspi_memory_mapped(&_qspi, &cmd) == QSPI_OK);
+  }
+  return success;
+}
@@ -0,0 +1,127 @@
+/*
+ * Quad SPI flash library for arduino.
+ * Drives a serial NOR flash memory through the QUADSPI or OCTOSPI
+ * peripheral: quad I/O indirect read/program/erase, and memory-mapped
+ * (execute in place) mode to read it straight from the address space.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _QSPIFLASH_H_INCLUDED
+#define _QSPIFLASH_H_INCLUDED
+
+#include "Arduino.h"
+#include "utility/qspi_com.h"
+
+#if !defined(QSPI_QUADSPI) && !defined(QSPI_OCTOSPI)
+#error "QSPIFlash requires HAL_QSPI_MODULE_ENABLED (or HAL_OSPI_MODULE_ENABLED) in hal_conf_extra.h"
+#endif
+
+// Default clock, the closest one below is used
+#ifndef QSPI_FLASH_DEFAULT_CLOCK
+#define QSPI_FLASH_DEFAULT_CLOCK  20000000
+#endif
+
+#if defined(QSPI_DMA_ENABLED)
+// Default minimum size in bytes of the DMA transfers
+#ifndef QSPI_DMA_THRESHOLD
+#define QSPI_DMA_THRESHOLD        64
+#endif
+#endif
+
+#define QSPI_FLASH_PAGE_SIZE      256
+#define QSPI_FLASH_SECTOR_SIZE    4096
+#define QSPI_FLASH_BLOCK_SIZE     65536
+
+class QSPIFlash {
+  public:
+    // Pins accepted format: number or Arduino format (Dx) or ST format (Pxy)
+    QSPIFlash(uint32_t data0, uint32_t data1, uint32_t data2, uint32_t data3,
+              uint32_t sclk, uint32_t ssel);
+
+    // Identify the memory and switch it to quad mode, false if not found
+    bool begin(uint32_t clock = QSPI_FLASH_DEFAULT_CLOCK);
+    void end(void);
+
+    // JEDEC ID: manufacturer, memory type and capacity bytes
+    uint32_t jedecId(void)
+    {
+      return _jedecId;
+    }
+    // Size in bytes, 0 if not initialized
+    uint32_t size(void)
+    {
+      return _size;
+    }
+
+    bool read(uint32_t address, void *buf, uint32_t count);
+    // Program erased memory, the pages are written one after the other
+    bool write(uint32_t address, const void *buf, uint32_t count);
+    // Erase the sector (4 KB) or the block (64 KB) holding the address
+    bool eraseSector(uint32_t address);
+    bool eraseBlock(uint32_t address);
+    bool eraseChip(void);
+
+    /* Memory-mapped mode: the memory is read through the returned pointer,
+     * NULL on error. It is left during the other operations and entered
+     * again at their end.
+     */
+    const uint8_t *enableMemoryMapped(void);
+    void disableMemoryMapped(void);
+    bool isMemoryMapped(void)
+    {
+      return _mapped;
+    }
+
+#if defined(QSPI_DMA_ENABLED)
+    // Use DMA for the transfers of at least QSPI_DMA_THRESHOLD bytes.
+    // request is the DMA request (or stream channel), unused on series with
+    // fixed DMA mapping. This needs to be done before the call to begin()
+    void setDMA(dma_channel_t *instance, uint32_t request = 0)
+    {
+      _qspi.dma = instance;
+      _qspi.dma_request = request;
+    }
+    // Minimum size in bytes of the DMA transfers, 0 to disable the DMA
+    void setDMAThreshold(uint16_t threshold)
+    {
+      _qspi.dma_threshold = threshold;
+    }
+#endif
+
+    // Could be used to mix Arduino API and STM32Cube HAL API. Use at your own risk.
+#if defined(QSPI_QUADSPI)
+    QSPI_HandleTypeDef *getHandle(void)
+#else
+    OSPI_HandleTypeDef *getHandle(void)
+#endif
+    {
+      return &(_qspi.handle);
+    }
+
+  private:
+    qspi_t   _qspi;
+    uint32_t _jedecId = 0;
+    uint32_t _size = 0;
+    /* Memory-mapped mode requested by the user */
+    bool     _mapped = false;
+    /* Commands depending on the memory */
+    uint8_t  _programCmd = 0;
+    uint8_t  _programAddressLines = 1;
+    uint8_t  _readDummy = 4;
+    uint8_t  _addressSize = 3;
+
+    bool command(uint8_t instruction, const void *tx_buf = NULL, void *rx_buf = NULL,
+                 uint32_t count = 0);
+    bool writeEnable(void);
+    bool waitReady(uint32_t timeout);
+    bool erase(uint8_t instruction, uint32_t address, uint32_t timeout);
+    bool quadEnable(void);
+    void readCommand(qspi_command_t *cmd, uint32_t address);
+    bool finish(bool success);
+};
+
+#endif /* _QSPIFLASH_H_INCLUDED */
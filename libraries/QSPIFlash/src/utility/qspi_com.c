@@ -0,0 +1,765 @@
+/*
+ * Utility of the quad SPI module for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+#include <string.h>
+#include "core_debug.h"
+#include "stm32_def.h"
+#include "utility/qspi_com.h"
+
+#if defined(QSPI_QUADSPI) || defined(QSPI_OCTOSPI)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(QSPI_QUADSPI)
+#define PinMap_QSPI_DATA0   PinMap_QUADSPI_DATA0
+#define PinMap_QSPI_DATA1   PinMap_QUADSPI_DATA1
+#define PinMap_QSPI_DATA2   PinMap_QUADSPI_DATA2
+#define PinMap_QSPI_DATA3   PinMap_QUADSPI_DATA3
+#define PinMap_QSPI_SCLK    PinMap_QUADSPI_SCLK
+#define PinMap_QSPI_SSEL    PinMap_QUADSPI_SSEL
+#else
+#define PinMap_QSPI_DATA0   PinMap_OCTOSPI_DATA0
+#define PinMap_QSPI_DATA1   PinMap_OCTOSPI_DATA1
+#define PinMap_QSPI_DATA2   PinMap_OCTOSPI_DATA2
+#define PinMap_QSPI_DATA3   PinMap_OCTOSPI_DATA3
+#define PinMap_QSPI_SCLK    PinMap_OCTOSPI_SCLK
+#define PinMap_QSPI_SSEL    PinMap_OCTOSPI_SSEL
+#endif
+
+#if defined(QSPI_DMA_ENABLED)
+#ifndef QSPI_IRQ_PRIO
+#define QSPI_IRQ_PRIO       2
+#endif
+#ifndef QSPI_IRQ_SUBPRIO
+#define QSPI_IRQ_SUBPRIO    0
+#endif
+/* DMA transfer length is limited by the channel data counter */
+#define QSPI_DMA_MAX_SIZE   0xFFFFU
+
+/* Handles of the instances, used by the IRQ handlers */
+static qspi_t *qspi_handles[2] = {NULL};
+#endif
+
+/* Private Functions */
+/**
+  * @brief  Return the kernel clock frequency of the QUADSPI/OCTOSPI
+  * @retval clock frequency in Hz
+  */
+static uint32_t qspi_getClkFreq(void)
+{
+  uint32_t freq = 0;
+
+#if defined(QSPI_QUADSPI) && defined(RCC_PERIPHCLK_QSPI)
+  freq = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_QSPI);
+#elif defined(QSPI_OCTOSPI) && defined(RCC_PERIPHCLK_OSPI)
+  freq = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_OSPI);
+#endif
+  if (freq == 0) {
+    /* Default source CLK is HCLK */
+    freq = HAL_RCC_GetHCLKFreq();
+  }
+  return freq;
+}
+
+/**
+  * @brief  Enable (and reset) or disable the clock of the instance
+  * @param  obj : pointer to qspi_t structure
+  * @param  enable : true to enable the clock
+  * @retval None
+  */
+static void qspi_clock(qspi_t *obj, bool enable)
+{
+#if defined(QSPI_QUADSPI)
+  UNUSED(obj);
+#if defined(__HAL_RCC_QSPI_CLK_ENABLE)
+  if (enable) {
+    __HAL_RCC_QSPI_CLK_ENABLE();
+  }
+  __HAL_RCC_QSPI_FORCE_RESET();
+  __HAL_RCC_QSPI_RELEASE_RESET();
+  if (!enable) {
+    __HAL_RCC_QSPI_CLK_DISABLE();
+  }
+#else
+  if (enable) {
+    __HAL_RCC_QUADSPI_CLK_ENABLE();
+  }
+  __HAL_RCC_QUADSPI_FORCE_RESET();
+  __HAL_RCC_QUADSPI_RELEASE_RESET();
+  if (!enable) {
+    __HAL_RCC_QUADSPI_CLK_DISABLE();
+  }
+#endif
+#else /* QSPI_OCTOSPI */
+  /* The IO manager is shared by both instances, it is left enabled */
+#if defined(__HAL_RCC_OSPIM_CLK_ENABLE)
+  __HAL_RCC_OSPIM_CLK_ENABLE();
+#elif defined(__HAL_RCC_OCTOSPIM_CLK_ENABLE)
+  __HAL_RCC_OCTOSPIM_CLK_ENABLE();
+#endif
+#if defined(OCTOSPI2)
+  if (obj->handle.Instance == OCTOSPI2) {
+    if (enable) {
+      __HAL_RCC_OSPI2_CLK_ENABLE();
+    }
+    __HAL_RCC_OSPI2_FORCE_RESET();
+    __HAL_RCC_OSPI2_RELEASE_RESET();
+    if (!enable) {
+      __HAL_RCC_OSPI2_CLK_DISABLE();
+    }
+  } else
+#endif
+  {
+    UNUSED(obj);
+    if (enable) {
+      __HAL_RCC_OSPI1_CLK_ENABLE();
+    }
+    __HAL_RCC_OSPI1_FORCE_RESET();
+    __HAL_RCC_OSPI1_RELEASE_RESET();
+    if (!enable) {
+      __HAL_RCC_OSPI1_CLK_DISABLE();
+    }
+  }
+#endif
+}
+
+/**
+  * @brief  Return the index of the instance
+  * @param  obj : pointer to qspi_t structure
+  * @retval 0 for QUADSPI or OCTOSPI1, 1 for OCTOSPI2
+  */
+static inline uint32_t qspi_index(qspi_t *obj)
+{
+#if defined(QSPI_OCTOSPI) && defined(OCTOSPI2)
+  if (obj->handle.Instance == OCTOSPI2) {
+    return 1;
+  }
+#else
+  UNUSED(obj);
+#endif
+  return 0;
+}
+
+/**
+  * @brief  Number of lines in the mode field format: 0 (none), 1, 2 or 3 (4 lines)
+  * @note   For all the phases, the xxx_1_LINE constant is the mode field set
+  *         to 1, so that the mode is this value multiplied by it.
+  */
+static inline uint32_t qspi_lines(uint8_t lines)
+{
+  return (lines >= 4) ? 3U : lines;
+}
+
+/**
+  * @brief  Send a command to the memory, without data transfer
+  * @param  obj : pointer to qspi_t structure
+  * @param  cmd : command to send
+  * @param  len : number of data bytes which follow the command
+  * @param  timeout : timeout in ms
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef qspi_send_command(qspi_t *obj, const qspi_command_t *cmd,
+                                           uint32_t len, uint32_t timeout)
+{
+  uint32_t address_size = (cmd->address_size == 0) ? 0U : (cmd->address_size - 1U);
+  uint8_t data_lines = ((len != 0) && (cmd->data_lines == 0)) ? 1 : cmd->data_lines;
+#if defined(QSPI_QUADSPI)
+  QSPI_CommandTypeDef command = {0};
+
+  command.Instruction = cmd->instruction;
+  command.InstructionMode = qspi_lines(cmd->instruction_lines) * QSPI_INSTRUCTION_1_LINE;
+  command.Address = cmd->address;
+  command.AddressMode = qspi_lines(cmd->address_lines) * QSPI_ADDRESS_1_LINE;
+  command.AddressSize = address_size * QSPI_ADDRESS_16_BITS;
+  command.AlternateBytes = cmd->alternate;
+  command.AlternateByteMode = qspi_lines(cmd->alternate_lines) * QSPI_ALTERNATE_BYTES_1_LINE;
+  command.AlternateBytesSize = QSPI_ALTERNATE_BYTES_8_BITS;
+  command.DummyCycles = cmd->dummy_cycles;
+  command.DataMode = (len == 0) ? QSPI_DATA_NONE : (qspi_lines(data_lines) * QSPI_DATA_1_LINE);
+  command.NbData = len;
+  command.DdrMode = QSPI_DDR_MODE_DISABLE;
+  command.SIOOMode = QSPI_SIOO_INST_EVERY_CMD;
+
+  return HAL_QSPI_Command(&(obj->handle), &command, timeout);
+#else
+  OSPI_RegularCmdTypeDef command = {0};
+
+  command.OperationType = HAL_OSPI_OPTYPE_COMMON_CFG;
+  command.FlashId = HAL_OSPI_FLASH_ID_1;
+  command.Instruction = cmd->instruction;
+  command.InstructionMode = qspi_lines(cmd->instruction_lines) * HAL_OSPI_INSTRUCTION_1_LINE;
+  command.InstructionSize = HAL_OSPI_INSTRUCTION_8_BITS;
+  command.InstructionDtrMode = HAL_OSPI_INSTRUCTION_DTR_DISABLE;
+  command.Address = cmd->address;
+  command.AddressMode = qspi_lines(cmd->address_lines) * HAL_OSPI_ADDRESS_1_LINE;
+  command.AddressSize = address_size * HAL_OSPI_ADDRESS_16_BITS;
+  command.AddressDtrMode = HAL_OSPI_ADDRESS_DTR_DISABLE;
+  command.AlternateBytes = cmd->alternate;
+  command.AlternateBytesMode = qspi_lines(cmd->alternate_lines) * HAL_OSPI_ALTERNATE_BYTES_1_LINE;
+  command.AlternateBytesSize = HAL_OSPI_ALTERNATE_BYTES_8_BITS;
+  command.AlternateBytesDtrMode = HAL_OSPI_ALTERNATE_BYTES_DTR_DISABLE;
+  command.DataMode = (len == 0) ? HAL_OSPI_DATA_NONE : (qspi_lines(data_lines) * HAL_OSPI_DATA_1_LINE);
+  command.NbData = len;
+  command.DataDtrMode = HAL_OSPI_DATA_DTR_DISABLE;
+  command.DummyCycles = cmd->dummy_cycles;
+  command.DQSMode = HAL_OSPI_DQS_DISABLE;
+  command.SIOOMode = HAL_OSPI_SIOO_INST_EVERY_CMD;
+
+  return HAL_OSPI_Command(&(obj->handle), &command, timeout);
+#endif
+}
+
+/**
+  * @brief  Convert a HAL status, aborting the operation on error
+  * @param  obj : pointer to qspi_t structure
+  * @param  status : HAL status
+  * @retval status of the operation
+  */
+static qspi_status_e qspi_status(qspi_t *obj, HAL_StatusTypeDef status)
+{
+  if (status == HAL_OK) {
+    return QSPI_OK;
+  }
+  qspi_abort(obj);
+  return (status == HAL_TIMEOUT) ? QSPI_TIMEOUT : QSPI_ERROR;
+}
+
+#if defined(QSPI_DMA_ENABLED)
+/**
+  * @brief  Return the IRQ number of the instance
+  * @param  obj : pointer to qspi_t structure
+  * @retval IRQ number
+  */
+static IRQn_Type qspi_irqn(qspi_t *obj)
+{
+#if defined(QSPI_QUADSPI)
+  UNUSED(obj);
+  return QUADSPI_IRQn;
+#elif defined(OCTOSPI2)
+  return (qspi_index(obj) == 1) ? OCTOSPI2_IRQn : OCTOSPI1_IRQn;
+#else
+  UNUSED(obj);
+  return OCTOSPI1_IRQn;
+#endif
+}
+
+/**
+  * @brief  Check if a transfer can be done by DMA
+  * @param  obj : pointer to qspi_t structure
+  * @param  rx_buffer : data to receive, NULL for a transmission
+  * @param  len : number of bytes
+  * @retval true if the DMA has to be used
+  */
+static bool qspi_dma_usable(qspi_t *obj, const void *rx_buffer, uint32_t len)
+{
+  if (!obj->dma_ready || (obj->dma_threshold == 0) || (len < obj->dma_threshold) ||
+      (len > QSPI_DMA_MAX_SIZE)) {
+    return false;
+  }
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  /* Received data are invalidated from the cache: whole lines only */
+  if ((rx_buffer != NULL) &&
+      ((((uint32_t)rx_buffer | len) & (DMA_DCACHE_LINE_SIZE - 1U)) != 0U)) {
+    return false;
+  }
+#else
+  UNUSED(rx_buffer);
+#endif
+  return true;
+}
+
+/**
+  * @brief  Wait for the end of a DMA transfer
+  * @param  obj : pointer to qspi_t structure
+  * @param  timeout : timeout in ms
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef qspi_dma_wait(qspi_t *obj, uint32_t timeout)
+{
+  uint32_t tickstart = HAL_GetTick();
+
+  /* Transfer ends from the QUADSPI/OCTOSPI interrupt */
+#if defined(QSPI_QUADSPI)
+  while (HAL_QSPI_GetState(&(obj->handle)) != HAL_QSPI_STATE_READY) {
+    if (HAL_QSPI_GetState(&(obj->handle)) == HAL_QSPI_STATE_ERROR) {
+      return HAL_ERROR;
+    }
+#else
+  while (HAL_OSPI_GetState(&(obj->handle)) != HAL_OSPI_STATE_READY) {
+    if (HAL_OSPI_GetState(&(obj->handle)) == HAL_OSPI_STATE_ERROR) {
+      return HAL_ERROR;
+    }
+#endif
+    if ((HAL_GetTick() - tickstart) >= timeout) {
+      return HAL_TIMEOUT;
+    }
+  }
+  return HAL_OK;
+}
+#endif /* QSPI_DMA_ENABLED */
+
+/* Public Functions */
+/**
+  * @brief  QUADSPI/OCTOSPI initialization, in quad mode
+  * @param  obj : pointer to qspi_t structure
+  * @param  speed : clock speed in Hz, the closest one below is used
+  * @param  size : memory size in bytes (power of 2)
+  * @retval true if initialized
+  */
+bool qspi_init(qspi_t *obj, uint32_t speed, uint32_t size)
+{
+  void *instance;
+  uint32_t freq;
+  uint32_t prescaler;
+  uint32_t size_bits;
+
+  if ((obj == NULL) || (speed == 0)) {
+    return false;
+  }
+  obj->memory_mapped = false;
+
+  // Determine the instance to use
+  void *qspi_d0 = pinmap_peripheral(obj->pin_data0, PinMap_QSPI_DATA0);
+  void *qspi_d1 = pinmap_peripheral(obj->pin_data1, PinMap_QSPI_DATA1);
+  void *qspi_d2 = pinmap_peripheral(obj->pin_data2, PinMap_QSPI_DATA2);
+  void *qspi_d3 = pinmap_peripheral(obj->pin_data3, PinMap_QSPI_DATA3);
+  void *qspi_sclk = pinmap_peripheral(obj->pin_sclk, PinMap_QSPI_SCLK);
+  void *qspi_ssel = pinmap_peripheral(obj->pin_ssel, PinMap_QSPI_SSEL);
+
+  /* All pins are required */
+  if ((qspi_d0 == NP) || (qspi_d1 == NP) || (qspi_d2 == NP) || (qspi_d3 == NP) ||
+      (qspi_sclk == NP) || (qspi_ssel == NP)) {
+    core_debug("ERROR: at least one QSPI pin has no peripheral\n");
+    return false;
+  }
+  instance = pinmap_merge_peripheral(pinmap_merge_peripheral(qspi_d0, qspi_d1),
+                                     pinmap_merge_peripheral(qspi_d2, qspi_d3));
+  instance = pinmap_merge_peripheral(instance, pinmap_merge_peripheral(qspi_sclk, qspi_ssel));
+
+  // Are all pins connected to the same instance?
+  if (instance == NP) {
+    core_debug("ERROR: QSPI pins mismatch\n");
+    return false;
+  }
+  obj->handle.Instance = instance;
+
+  qspi_clock(obj, true);
+  pinmap_pinout(obj->pin_data0, PinMap_QSPI_DATA0);
+  pinmap_pinout(obj->pin_data1, PinMap_QSPI_DATA1);
+  pinmap_pinout(obj->pin_data2, PinMap_QSPI_DATA2);
+  pinmap_pinout(obj->pin_data3, PinMap_QSPI_DATA3);
+  pinmap_pinout(obj->pin_sclk, PinMap_QSPI_SCLK);
+  pinmap_pinout(obj->pin_ssel, PinMap_QSPI_SSEL);
+
+  /* Highest clock below the requested speed */
+  freq = qspi_getClkFreq();
+  prescaler = (freq + speed - 1) / speed;
+  if (prescaler == 0) {
+    prescaler = 1;
+  } else if (prescaler > 256) {
+    prescaler = 256;
+  }
+  /* Number of address bits */
+  size_bits = (size < 2) ? 32U : POSITION_VAL(size);
+
+#if defined(QSPI_QUADSPI)
+  obj->handle.Init.ClockPrescaler = prescaler - 1;
+  obj->handle.Init.FifoThreshold = 4;
+  obj->handle.Init.SampleShifting = QSPI_SAMPLE_SHIFTING_HALFCYCLE;
+  obj->handle.Init.FlashSize = size_bits - 1;
+  obj->handle.Init.ChipSelectHighTime = QSPI_CS_HIGH_TIME_2_CYCLE;
+  obj->handle.Init.ClockMode = QSPI_CLOCK_MODE_0;
+#if defined(QUADSPI_CR_DFM)
+  /* Memory on the bank 1 pins */
+  obj->handle.Init.FlashID = QSPI_FLASH_ID_1;
+  obj->handle.Init.DualFlash = QSPI_DUALFLASH_DISABLE;
+#endif
+  if (HAL_QSPI_Init(&(obj->handle)) != HAL_OK) {
+    return false;
+  }
+#else
+  /* Fields not set are left disabled */
+  memset(&(obj->handle.Init), 0, sizeof(obj->handle.Init));
+  obj->handle.Init.FifoThreshold = 4;
+  obj->handle.Init.DualQuad = HAL_OSPI_DUALQUAD_DISABLE;
+  obj->handle.Init.MemoryType = HAL_OSPI_MEMTYPE_MICRON;
+  obj->handle.Init.DeviceSize = size_bits;
+  obj->handle.Init.ChipSelectHighTime = 2;
+  obj->handle.Init.FreeRunningClock = HAL_OSPI_FREERUNCLK_DISABLE;
+  obj->handle.Init.ClockMode = HAL_OSPI_CLOCK_MODE_0;
+  obj->handle.Init.ClockPrescaler = prescaler;
+  obj->handle.Init.SampleShifting = HAL_OSPI_SAMPLE_SHIFTING_HALFCYCLE;
+  obj->handle.Init.DelayHoldQuarterCycle = HAL_OSPI_DHQC_DISABLE;
+  obj->handle.Init.DelayBlockBypass = HAL_OSPI_DELAY_BLOCK_BYPASSED;
+  if (HAL_OSPI_Init(&(obj->handle)) != HAL_OK) {
+    return false;
+  }
+#if defined(OCTOSPIM)
+  /* Route the pins port (P1 or P2 from the pin map) to the instance */
+  OSPIM_CfgTypeDef cfg = {0};
+  uint32_t port = qspi_index(obj) + 1;
+
+  cfg.ClkPort = port;
+  cfg.NCSPort = port;
+  cfg.IOLowPort = (port == 1) ? HAL_OSPIM_IOPORT_1_LOW : HAL_OSPIM_IOPORT_2_LOW;
+  cfg.IOHighPort = HAL_OSPIM_IOPORT_NONE;
+#if defined(OCTOSPIM_CR_MUXEN)
+  cfg.Req2AckTime = 1;
+#endif
+  if (HAL_OSPIM_Config(&(obj->handle), &cfg, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK) {
+    return false;
+  }
+#endif
+#endif
+
+#if defined(QSPI_DMA_ENABLED)
+  qspi_dma_init(obj);
+#endif
+  return true;
+}
+
+/**
+  * @brief  QUADSPI/OCTOSPI deinitialization
+  * @param  obj : pointer to qspi_t structure
+  * @retval None
+  */
+void qspi_deinit(qspi_t *obj)
+{
+  if ((obj == NULL) || (obj->handle.Instance == NULL)) {
+    return;
+  }
+  qspi_abort(obj);
+#if defined(QSPI_QUADSPI)
+  HAL_QSPI_DeInit(&(obj->handle));
+#else
+  HAL_OSPI_DeInit(&(obj->handle));
+#endif
+#if defined(QSPI_DMA_ENABLED)
+  if (obj->dma_ready) {
+    HAL_NVIC_DisableIRQ(qspi_irqn(obj));
+    dma_deinit(&(obj->hdma));
+    obj->dma_ready = false;
+  }
+  qspi_handles[qspi_index(obj)] = NULL;
+#endif
+  qspi_clock(obj, false);
+}
+
+/**
+  * @brief  Send a command, followed by data sent or received in indirect mode
+  * @note   Memory-mapped mode is left, if active.
+  * @param  obj : pointer to qspi_t structure
+  * @param  cmd : command to send
+  * @param  tx_buffer : data to send, NULL to receive
+  * @param  rx_buffer : data received, NULL to send
+  * @param  len : number of data bytes, 0 for a command without data
+  * @param  timeout : timeout in ms
+  * @retval status of the operation
+  */
+qspi_status_e qspi_command(qspi_t *obj, const qspi_command_t *cmd,
+                           const uint8_t *tx_buffer, uint8_t *rx_buffer,
+                           uint32_t len, uint32_t timeout)
+{
+  HAL_StatusTypeDef status;
+
+  if ((obj == NULL) || (cmd == NULL) ||
+      ((len != 0) && (tx_buffer == NULL) && (rx_buffer == NULL))) {
+    return QSPI_ERROR;
+  }
+  if (obj->memory_mapped) {
+    qspi_abort(obj);
+  }
+
+  status = qspi_send_command(obj, cmd, len, timeout);
+  if ((status == HAL_OK) && (len != 0)) {
+#if defined(QSPI_DMA_ENABLED)
+    if (qspi_dma_usable(obj, (tx_buffer != NULL) ? NULL : rx_buffer, len)) {
+      if (tx_buffer != NULL) {
+        dma_clean_dcache(tx_buffer, len);
+#if defined(QSPI_QUADSPI)
+        status = HAL_QSPI_Transmit_DMA(&(obj->handle), (uint8_t *)tx_buffer);
+#else
+        status = HAL_OSPI_Transmit_DMA(&(obj->handle), (uint8_t *)tx_buffer);
+#endif
+      } else {
+#if defined(QSPI_QUADSPI)
+        status = HAL_QSPI_Receive_DMA(&(obj->handle), rx_buffer);
+#else
+        status = HAL_OSPI_Receive_DMA(&(obj->handle), rx_buffer);
+#endif
+      }
+      if (status == HAL_OK) {
+        status = qspi_dma_wait(obj, timeout);
+      }
+      if ((status == HAL_OK) && (tx_buffer == NULL)) {
+        dma_invalidate_dcache(rx_buffer, len);
+      }
+    } else
+#endif
+    {
+#if defined(QSPI_QUADSPI)
+      if (tx_buffer != NULL) {
+        status = HAL_QSPI_Transmit(&(obj->handle), (uint8_t *)tx_buffer, timeout);
+      } else {
+        status = HAL_QSPI_Receive(&(obj->handle), rx_buffer, timeout);
+      }
+#else
+      if (tx_buffer != NULL) {
+        status = HAL_OSPI_Transmit(&(obj->handle), (uint8_t *)tx_buffer, timeout);
+      } else {
+        status = HAL_OSPI_Receive(&(obj->handle), rx_buffer, timeout);
+      }
+#endif
+    }
+  }
+  return qspi_status(obj, status);
+}
+
+/**
+  * @brief  Read a status register until the masked bits match, the polling
+  *         being done by the peripheral
+  * @param  obj : pointer to qspi_t structure
+  * @param  cmd : read status register command, one byte of data
+  * @param  match : value to match
+  * @param  mask : bits to compare
+  * @param  timeout : timeout in ms
+  * @retval status of the operation
+  */
+qspi_status_e qspi_poll_status(qspi_t *obj, const qspi_command_t *cmd,
+                               uint8_t match, uint8_t mask, uint32_t timeout)
+{
+  HAL_StatusTypeDef status;
+
+  if ((obj == NULL) || (cmd == NULL)) {
+    return QSPI_ERROR;
+  }
+  if (obj->memory_mapped) {
+    qspi_abort(obj);
+  }
+
+#if defined(QSPI_QUADSPI)
+  QSPI_CommandTypeDef command = {0};
+  QSPI_AutoPollingTypeDef config = {0};
+
+  command.Instruction = cmd->instruction;
+  command.InstructionMode = qspi_lines(cmd->instruction_lines) * QSPI_INSTRUCTION_1_LINE;
+  command.AddressMode = QSPI_ADDRESS_NONE;
+  command.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+  command.DummyCycles = cmd->dummy_cycles;
+  command.DataMode = qspi_lines((cmd->data_lines == 0) ? 1 : cmd->data_lines) * QSPI_DATA_1_LINE;
+  command.DdrMode = QSPI_DDR_MODE_DISABLE;
+  command.SIOOMode = QSPI_SIOO_INST_EVERY_CMD;
+
+  config.Match = match;
+  config.Mask = mask;
+  config.MatchMode = QSPI_MATCH_MODE_AND;
+  config.StatusBytesSize = 1;
+  config.Interval = 0x10;
+  config.AutomaticStop = QSPI_AUTOMATIC_STOP_ENABLE;
+
+  status = HAL_QSPI_AutoPolling(&(obj->handle), &command, &config, timeout);
+#else
+  qspi_command_t polling = *cmd;
+  OSPI_AutoPollingTypeDef config = {0};
+
+  polling.address_lines = 0;
+  polling.alternate_lines = 0;
+  status = qspi_send_command(obj, &polling, 1, timeout);
+  if (status == HAL_OK) {
+    config.Match = match;
+    config.Mask = mask;
+    config.MatchMode = HAL_OSPI_MATCH_MODE_AND;
+    config.AutomaticStop = HAL_OSPI_AUTOMATIC_STOP_ENABLE;
+    config.Interval = 0x10;
+    status = HAL_OSPI_AutoPolling(&(obj->handle), &config, timeout);
+  }
+#endif
+  return qspi_status(obj, status);
+}
+
+/**
+  * @brief  Enter the memory-mapped mode: the memory is read with the given
+  *         command when accessed through the address space
+  * @param  obj : pointer to qspi_t structure
+  * @param  cmd : read command, its address is unused
+  * @retval status of the operation
+  */
+qspi_status_e qspi_memory_mapped(qspi_t *obj, const qspi_command_t *cmd)
+{
+  HAL_StatusTypeDef status;
+
+  if ((obj == NULL) || (cmd == NULL)) {
+    return QSPI_ERROR;
+  }
+  if (obj->memory_mapped) {
+    qspi_abort(obj);
+  }
+
+#if defined(QSPI_QUADSPI)
+  QSPI_CommandTypeDef command = {0};
+  QSPI_MemoryMappedTypeDef config = {0};
+
+  command.Instruction = cmd->instruction;
+  command.InstructionMode = qspi_lines(cmd->instruction_lines) * QSPI_INSTRUCTION_1_LINE;
+  command.AddressMode = qspi_lines(cmd->address_lines) * QSPI_ADDRESS_1_LINE;
+  command.AddressSize = ((cmd->address_size == 0) ? 0U : (cmd->address_size - 1U)) * QSPI_ADDRESS_16_BITS;
+  command.AlternateBytes = cmd->alternate;
+  command.AlternateByteMode = qspi_lines(cmd->alternate_lines) * QSPI_ALTERNATE_BYTES_1_LINE;
+  command.AlternateBytesSize = QSPI_ALTERNATE_BYTES_8_BITS;
+  command.DummyCycles = cmd->dummy_cycles;
+  command.DataMode = qspi_lines((cmd->data_lines == 0) ? 1 : cmd->data_lines) * QSPI_DATA_1_LINE;
+  command.DdrMode = QSPI_DDR_MODE_DISABLE;
+  command.SIOOMode = QSPI_SIOO_INST_EVERY_CMD;
+
+  /* Chip select stays low between the accesses, for the prefetch */
+  config.TimeOutActivation = QSPI_TIMEOUT_COUNTER_DISABLE;
+  config.TimeOutPeriod = 0;
+
+  status = HAL_QSPI_MemoryMapped(&(obj->handle), &command, &config);
+#else
+  OSPI_MemoryMappedTypeDef config = {0};
+
+  /* Read configuration only: the memory is not written through the address space */
+  status = qspi_send_command(obj, cmd, 1, HAL_OSPI_TIMEOUT_DEFAULT_VALUE);
+  if (status == HAL_OK) {
+    config.TimeOutActivation = HAL_OSPI_TIMEOUT_COUNTER_DISABLE;
+    config.TimeOutPeriod = 0;
+    status = HAL_OSPI_MemoryMapped(&(obj->handle), &config);
+  }
+#endif
+  obj->memory_mapped = (status == HAL_OK);
+  return qspi_status(obj, status);
+}
+
+/**
+  * @brief  Abort the ongoing operation, or leave the memory-mapped mode
+  * @param  obj : pointer to qspi_t structure
+  * @retval status of the operation
+  */
+qspi_status_e qspi_abort(qspi_t *obj)
+{
+  HAL_StatusTypeDef status;
+
+  if (obj == NULL) {
+    return QSPI_ERROR;
+  }
+  obj->memory_mapped = false;
+#if defined(QSPI_QUADSPI)
+  if (HAL_QSPI_GetState(&(obj->handle)) == HAL_QSPI_STATE_ERROR) {
+    /* Not aborted by the HAL from this state: abort and reinitialize */
+    SET_BIT(obj->handle.Instance->CR, QUADSPI_CR_ABORT);
+    status = HAL_QSPI_Init(&(obj->handle));
+  } else {
+    status = HAL_QSPI_Abort(&(obj->handle));
+  }
+#else
+  if (HAL_OSPI_GetState(&(obj->handle)) == HAL_OSPI_STATE_ERROR) {
+    /* Not aborted by the HAL from this state: abort and reinitialize */
+    SET_BIT(obj->handle.Instance->CR, OCTOSPI_CR_ABORT);
+    status = HAL_OSPI_Init(&(obj->handle));
+  } else {
+    status = HAL_OSPI_Abort(&(obj->handle));
+  }
+#endif
+  return (status == HAL_OK) ? QSPI_OK : QSPI_ERROR;
+}
+
+/**
+  * @brief  Return the start address of the memory-mapped region
+  * @param  obj : pointer to qspi_t structure
+  * @retval memory address, byte 0 of the memory
+  */
+const uint8_t *qspi_memory_base(qspi_t *obj)
+{
+#if defined(QSPI_QUADSPI)
+  UNUSED(obj);
+  return (const uint8_t *)QSPI_MEMORY_BASE;
+#else
+#if defined(OCTOSPI2)
+  if (qspi_index(obj) == 1) {
+    return (const uint8_t *)OCTOSPI2_BASE;
+  }
+#else
+  UNUSED(obj);
+#endif
+  return (const uint8_t *)OCTOSPI1_BASE;
+#endif
+}
+
+#if defined(QSPI_DMA_ENABLED)
+/**
+  * @brief  Initialize the DMA channel requested for the transfers, and the
+  *         interrupt which ends them
+  * @param  obj : pointer to qspi_t structure
+  * @retval None
+  */
+void qspi_dma_init(qspi_t *obj)
+{
+  IRQn_Type irqn = qspi_irqn(obj);
+
+  obj->dma_ready = false;
+  if ((obj->dma == NULL) ||
+      !dma_init(&(obj->hdma), obj->dma, obj->dma_request, DMA_PERIPH_TO_MEMORY, DMA_NORMAL, 1)) {
+    return;
+  }
+  /* Direction is set by the HAL for each transfer */
+  __HAL_LINKDMA(&(obj->handle), hdma, obj->hdma);
+  qspi_handles[qspi_index(obj)] = obj;
+  HAL_NVIC_SetPriority(irqn, QSPI_IRQ_PRIO, QSPI_IRQ_SUBPRIO);
+  HAL_NVIC_EnableIRQ(irqn);
+  obj->dma_ready = true;
+}
+
+#if defined(QSPI_QUADSPI)
+/**
+  * @brief  QUADSPI IRQ handler, ends the DMA transfers
+  * @param  None
+  * @retval None
+  */
+void QUADSPI_IRQHandler(void)
+{
+  if (qspi_handles[0] != NULL) {
+    HAL_QSPI_IRQHandler(&(qspi_handles[0]->handle));
+  }
+}
+#else
+/**
+  * @brief  OCTOSPI1 IRQ handler, ends the DMA transfers
+  * @param  None
+  * @retval None
+  */
+void OCTOSPI1_IRQHandler(void)
+{
+  if (qspi_handles[0] != NULL) {
+    HAL_OSPI_IRQHandler(&(qspi_handles[0]->handle));
+  }
+}
+
+#if defined(OCTOSPI2)
+/**
+  * @brief  OCTOSPI2 IRQ handler, ends the DMA transfers
+  * @param  None
+  * @retval None
+  */
+void OCTOSPI2_IRQHandler(void)
+{
+  if (qspi_handles[1] != NULL) {
+    HAL_OSPI_IRQHandler(&(qspi_handles[1]->handle));
+  }
+}
+#endif
+#endif
+#endif /* QSPI_DMA_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QSPI_QUADSPI || QSPI_OCTOSPI */
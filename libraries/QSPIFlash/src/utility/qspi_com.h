@@ -0,0 +1,131 @@
+/*
+ * Header utility of the quad SPI module for arduino.
+ * Drives a QUADSPI or an OCTOSPI instance (in quad mode) through the HAL.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __QSPI_COM_H
+#define __QSPI_COM_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32_def.h"
+#include "PeripheralPins.h"
+#include "dma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * HAL_QSPI_MODULE_ENABLED or HAL_OSPI_MODULE_ENABLED has to be defined,
+ * in hal_conf_extra.h or build_opt.h, depending on the series.
+ */
+#if defined(HAL_QSPI_MODULE_ENABLED) && !defined(HAL_QSPI_MODULE_ONLY) &&\
+    defined(QUADSPI) && !defined(STM32MP1xx)
+#define QSPI_QUADSPI
+#elif defined(HAL_OSPI_MODULE_ENABLED) && !defined(HAL_OSPI_MODULE_ONLY) &&\
+    defined(OCTOSPI1)
+#define QSPI_OCTOSPI
+#endif
+
+#if defined(QSPI_QUADSPI) || defined(QSPI_OCTOSPI)
+
+/*
+ * DMA not supported by this series: transfers are polled.
+ * STM32H7xx QUADSPI/OCTOSPI are served by the MDMA, not managed.
+ */
+#if defined(QSPI_DMA_ENABLED) && (!defined(DMA_WRAPPER_ENABLED) || defined(STM32H7xx))
+#undef QSPI_DMA_ENABLED
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+  QSPI_OK = 0,
+  QSPI_TIMEOUT = 1,
+  QSPI_ERROR = 2
+} qspi_status_e;
+
+typedef struct {
+#if defined(QSPI_QUADSPI)
+  QSPI_HandleTypeDef handle;
+#else
+  OSPI_HandleTypeDef handle;
+#endif
+  PinName pin_data0;
+  PinName pin_data1;
+  PinName pin_data2;
+  PinName pin_data3;
+  PinName pin_sclk;
+  PinName pin_ssel;
+  /* Memory-mapped mode is active */
+  bool memory_mapped;
+#if defined(QSPI_DMA_ENABLED)
+  /* DMA channel requested, NULL to poll all the transfers */
+  dma_channel_t *dma;
+  uint32_t dma_request;
+  DMA_HandleTypeDef hdma;
+  bool dma_ready;
+  /* Minimum size of the DMA transfers, 0 to disable the DMA */
+  uint16_t dma_threshold;
+#endif
+} qspi_t;
+
+/* Command sent to the memory: each phase is skipped when its lines is 0 */
+typedef struct {
+  uint8_t instruction;
+  uint8_t instruction_lines;
+  uint32_t address;
+  /* Address size in bytes: 1 to 4 */
+  uint8_t address_size;
+  uint8_t address_lines;
+  /* Mode byte, sent after the address */
+  uint8_t alternate;
+  uint8_t alternate_lines;
+  uint8_t dummy_cycles;
+  uint8_t data_lines;
+} qspi_command_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Start address of the memory-mapped region */
+#if defined(QSPI_QUADSPI)
+#if defined(QSPI_BASE)
+#define QSPI_MEMORY_BASE      QSPI_BASE
+#elif defined(QUADSPI_BASE)
+#define QSPI_MEMORY_BASE      QUADSPI_BASE
+#else
+#define QSPI_MEMORY_BASE      0x90000000UL
+#endif
+#endif
+
+/* Default timeout of a command or a transfer, in ms */
+#ifndef QSPI_TIMEOUT_MS
+#define QSPI_TIMEOUT_MS       1000
+#endif
+
+/* Exported functions ------------------------------------------------------- */
+bool qspi_init(qspi_t *obj, uint32_t speed, uint32_t size);
+void qspi_deinit(qspi_t *obj);
+qspi_status_e qspi_command(qspi_t *obj, const qspi_command_t *cmd,
+                           const uint8_t *tx_buffer, uint8_t *rx_buffer,
+                           uint32_t len, uint32_t timeout);
+qspi_status_e qspi_poll_status(qspi_t *obj, const qspi_command_t *cmd,
+                               uint8_t match, uint8_t mask, uint32_t timeout);
+qspi_status_e qspi_memory_mapped(qspi_t *obj, const qspi_command_t *cmd);
+qspi_status_e qspi_abort(qspi_t *obj);
+const uint8_t *qspi_memory_base(qspi_t *obj);
+#if defined(QSPI_DMA_ENABLED)
+void qspi_dma_init(qspi_t *obj);
+#endif
+
+#endif /* QSPI_QUADSPI || QSPI_OCTOSPI */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __QSPI_COM_H */
@@ -0,0 +1,73 @@
+/*
+  SPI benchmark
+
+  Measures the throughput of the SPI transfers for several buffer sizes and
+  reports the achieved bit rate versus the configured clock.
+
+  The SPI clock is the peripheral clock divided by a power of 2, the closest
+  one below the requested clock is used: the achieved rate can not exceed it.
+  The gap shows the time the bus is idle between frames.
+
+  Connect MOSI to MISO to check the received data (optional).
+
+  This example code is in the public domain.
+*/
+
+#include <SPI.h>
+
+#define SPI_CLOCK   8000000
+#define BUFFER_SIZE 4096
+#define ITERATIONS  16
+
+static uint8_t tx_buffer[BUFFER_SIZE];
+static uint8_t rx_buffer[BUFFER_SIZE];
+
+void benchmark(const char *name, size_t size, bool receive)
+{
+  uint32_t start = micros();
+  for (int i = 0; i < ITERATIONS; i++) {
+    SPI.transfer(tx_buffer, receive ? rx_buffer : NULL, size);
+  }
+  uint32_t elapsed = micros() - start;
+  // bits per microsecond is MHz
+  float mhz = (8.0f * size * ITERATIONS) / elapsed;
+
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print(size);
+  Serial.print(" bytes: ");
+  Serial.print(mhz, 3);
+  Serial.print(" MHz (");
+  Serial.print((100.0f * mhz * 1000000) / SPI_CLOCK, 1);
+  Serial.print("% of ");
+  Serial.print(SPI_CLOCK / 1000000.0f, 3);
+  Serial.println(" MHz)");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+
+  for (size_t i = 0; i < BUFFER_SIZE; i++) {
+    tx_buffer[i] = i;
+  }
+  SPI.begin();
+  SPI.beginTransaction(SPISettings(SPI_CLOCK, MSBFIRST, SPI_MODE0));
+
+  for (size_t size = 1; size <= BUFFER_SIZE; size *= 4) {
+    benchmark("TX only    ", size, false);
+    benchmark("Full duplex", size, true);
+  }
+  SPI.endTransaction();
+
+  if (memcmp(tx_buffer, rx_buffer, BUFFER_SIZE) == 0) {
+    Serial.println("Loopback data OK");
+  } else {
+    Serial.println("No loopback (MOSI not connected to MISO)");
+  }
+}
+
+void loop()
+{
+}
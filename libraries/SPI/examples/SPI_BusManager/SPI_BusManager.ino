@@ -0,0 +1,70 @@
+/*
+  SPI bus manager
+
+  Two devices share the SPI bus with their own settings and chip select:
+  a flash memory at 20 MHz and an ADC at 1 MHz. Their transactions are
+  queued and run back to back, the chip selects being driven by the bus.
+
+  With SPI_DMA_ENABLED defined and DMA channels set with SPI.setTxDMA() and
+  SPI.setRxDMA(), the transactions run in background.
+
+  This example code is in the public domain.
+*/
+
+#include <SPIBus.h>
+
+#define FLASH_CS 10
+#define ADC_CS   9
+
+SPIDevice flash(SPISettings(20000000, MSBFIRST, SPI_MODE0), FLASH_CS);
+SPIDevice adc(SPISettings(1000000, MSBFIRST, SPI_MODE3), ADC_CS);
+SPIBus bus(SPI);
+
+// Read JEDEC ID command
+static const uint8_t flash_cmd[] = { 0x9F };
+static uint8_t flash_id[3];
+static uint8_t adc_tx[2] = { 0x80, 0x00 };
+static uint8_t adc_rx[2];
+static volatile uint32_t samples = 0;
+
+void adcDone(void *arg, bool success)
+{
+  (void)arg;
+  if (success) {
+    samples++;
+  }
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+
+  SPI.begin();
+  flash.begin();
+  adc.begin();
+
+  bus.queueCommand(flash, flash_cmd, sizeof(flash_cmd), NULL, flash_id, sizeof(flash_id));
+  bus.flush();
+  Serial.print("Flash JEDEC ID: ");
+  for (size_t i = 0; i < sizeof(flash_id); i++) {
+    Serial.print(flash_id[i], HEX);
+    Serial.print(" ");
+  }
+  Serial.println();
+}
+
+void loop()
+{
+  uint32_t start = millis();
+
+  samples = 0;
+  while (millis() - start < 1000) {
+    // Alternate both devices, the queue never runs empty
+    bus.queue(adc, adc_tx, adc_rx, sizeof(adc_rx), adcDone);
+    bus.queueCommand(flash, flash_cmd, sizeof(flash_cmd), NULL, flash_id, sizeof(flash_id));
+  }
+  bus.flush();
+  Serial.print("ADC samples per second: ");
+  Serial.println(samples);
+}
@@ -13,6 +13,32 @@
 
 SPIClass SPI;
 
+/**
+  * @brief  Set the default transfer state: no asynchronous transfer, no DMA.
+  * @param  spi: pointer to spi_t structure
+  */
+static void initTransfer(spi_t *spi)
+{
+  spi->async_busy = 0;
+  spi->async_status = SPI_OK;
+  spi->async_callback = NULL;
+  spi->async_polling = 0;
+  spi->async_len = 0;
+#if defined(SPI_DMA_ENABLED)
+  spi->dma_tx = NULL;
+  spi->dma_tx_request = 0;
+  spi->dma_rx = NULL;
+  spi->dma_rx_request = 0;
+  spi->dma_threshold = SPI_DMA_THRESHOLD;
+  spi->dma_ready = 0;
+  spi->slave_active = 0;
+  spi->slave_callback = NULL;
+  spi->slave_tx = NULL;
+  spi->slave_tx_len = 0;
+  spi->slave_tx_pending = 0;
+#endif
+}
+
 /**
   * @brief  Default constructor. Uses pin configuration of variant.h.
   */
@@ -22,6 +48,7 @@ SPIClass::SPIClass()
   _spi.pin_mosi = digitalPinToPinName(MOSI);
   _spi.pin_sclk = digitalPinToPinName(SCK);
   _spi.pin_ssel = NC;
+  initTransfer(&_spi);
 }
 
 /**
@@ -49,6 +76,7 @@ SPIClass::SPIClass(uint32_t mosi, uint32_t miso, uint32_t sclk, uint32_t ssel)
   _spi.pin_mosi = digitalPinToPinName(mosi);
   _spi.pin_sclk = digitalPinToPinName(sclk);
   _spi.pin_ssel = digitalPinToPinName(ssel);
+  initTransfer(&_spi);
 }
 
 /**
@@ -58,9 +86,15 @@ void SPIClass::begin(void)
 {
   _spi.handle.State = HAL_SPI_STATE_RESET;
   _spiSettings = SPISettings();
+  /* SPI clock could have changed since the settings were resolved */
+  _settingsCount = 0;
+  _settingsNext = 0;
   spi_init(&_spi, _spiSettings.clockFreq,
            _spiSettings.dataMode,
            _spiSettings.bitOrder);
+#if defined(SPI_DMA_ENABLED)
+  spi_attach_dma(&_spi);
+#endif
 }
 
 /**
@@ -72,10 +106,45 @@ void SPIClass::beginTransaction(SPISettings settings)
 {
   if (_spiSettings != settings) {
     _spiSettings = settings;
+    applySettings();
+  }
+}
+
+/**
+  * @brief  Apply the current settings. Once the SPI is initialized, they are
+  *         resolved into register values the first time only, and then written
+  *         without resetting nor initializing the SPI again.
+  */
+void SPIClass::applySettings(void)
+{
+  CachedSettings *cached;
+
+  if (_spi.handle.State == HAL_SPI_STATE_RESET) {
     spi_init(&_spi, _spiSettings.clockFreq,
              _spiSettings.dataMode,
              _spiSettings.bitOrder);
+    return;
   }
+
+  for (uint8_t i = 0; i < _settingsCount; i++) {
+    if (_settingsCache[i].settings == _spiSettings) {
+      spi_set_config(&_spi, &_settingsCache[i].config);
+      return;
+    }
+  }
+
+  /* Replace the oldest one when the cache is full */
+  cached = &_settingsCache[_settingsNext];
+  cached->settings = _spiSettings;
+  spi_get_config(&_spi, _spiSettings.clockFreq,
+                 _spiSettings.dataMode,
+                 _spiSettings.bitOrder,
+                 &cached->config);
+  _settingsNext = (_settingsNext + 1) % SPI_SETTINGS_CACHE_SIZE;
+  if (_settingsCount < SPI_SETTINGS_CACHE_SIZE) {
+    _settingsCount++;
+  }
+  spi_set_config(&_spi, &cached->config);
 }
 
 /**
@@ -91,9 +160,57 @@ void SPIClass::endTransaction(void)
   */
 void SPIClass::end(void)
 {
+#if defined(SPI_DMA_ENABLED)
+  if (_spi.slave_active) {
+    ::detachInterrupt(pinNametoDigitalPin(_spi.pin_ssel));
+  }
+#endif
   spi_deinit(&_spi);
 }
 
+#if defined(SPI_DMA_ENABLED)
+/**
+  * @brief  Initialize the SPI instance in slave mode and start receiving.
+  *         The ssel pin must be defined, DMA channels set with setTxDMA()
+  *         and setRxDMA(). The response is set with setSlaveResponse(),
+  *         dummy 0xFF bytes are sent without it.
+  * @param  settings: SPI settings, only the bit order and data mode are used.
+  * @param  rx_buf0: first buffer of the received frames.
+  * @param  rx_buf1: second buffer of the received frames.
+  * @param  size: size of each buffer, longest frame received.
+  * @param  callback: function called at the end of each frame, from the
+  *         interrupt of the ssel pin.
+  * @param  arg: argument given to the callback.
+  * @note   The time between two frames must be long enough for the
+  *         interrupt to set the DMA for the next one.
+  * @return true if the slave mode is started.
+  */
+bool SPIClass::beginSlave(SPISettings settings, uint8_t *rx_buf0, uint8_t *rx_buf1, uint16_t size,
+                          void (*callback)(void *arg, uint8_t *rx_buf, uint16_t count),
+                          void *arg)
+{
+  uint32_t ssel = pinNametoDigitalPin(_spi.pin_ssel);
+
+  _spiSettings = settings;
+  _settingsCount = 0;
+  _settingsNext = 0;
+  if (spi_slave_init(&_spi, _spiSettings.dataMode, _spiSettings.bitOrder) != SPI_OK) {
+    return false;
+  }
+  spi_attach_dma(&_spi);
+  /* End of frame on the ssel rising edge, its alternate function is set back by the start */
+  ::attachInterrupt(ssel, [this]() {
+    spi_slave_frame_end(&_spi);
+  }, RISING);
+  if (spi_slave_start(&_spi, rx_buf0, rx_buf1, size, callback, arg) != SPI_OK) {
+    ::detachInterrupt(ssel);
+    spi_deinit(&_spi);
+    return false;
+  }
+  return true;
+}
+#endif
+
 /**
   * @brief  Deprecated function.
   *         Configure the bit order: MSB first or LSB first.
@@ -103,9 +220,7 @@ void SPIClass::setBitOrder(BitOrder bitOrder)
 {
   _spiSettings.bitOrder = bitOrder;
 
-  spi_init(&_spi, _spiSettings.clockFreq,
-           _spiSettings.dataMode,
-           _spiSettings.bitOrder);
+  applySettings();
 }
 
 /**
@@ -127,9 +242,7 @@ void SPIClass::setDataMode(uint8_t mode)
 void SPIClass::setDataMode(SPIMode mode)
 {
   _spiSettings.dataMode = mode;
-  spi_init(&_spi, _spiSettings.clockFreq,
-           _spiSettings.dataMode,
-           _spiSettings.bitOrder);
+  applySettings();
 }
 
 /**
@@ -147,9 +260,7 @@ void SPIClass::setClockDivider(uint8_t divider)
     _spiSettings.clockFreq = spi_getClkFreq(&_spi) / divider;
   }
 
-  spi_init(&_spi, _spiSettings.clockFreq,
-           _spiSettings.dataMode,
-           _spiSettings.bitOrder);
+  applySettings();
 }
 
 /**
@@ -168,32 +279,65 @@ uint8_t SPIClass::transfer(uint8_t data, bool skipReceive)
 }
 
 /**
-  * @brief  Transfer two bytes on the SPI bus in 16 bits format.
+  * @brief  Transfer a 16-bit frame on the SPI bus.
   *         begin() or beginTransaction() must be called at least once before.
-  * @param  data: bytes to send.
+  * @param  data: frame to send.
   * @param  skipReceive: skip receiving data after transmit or not.
   *         SPI_TRANSMITRECEIVE or SPI_TRANSMITONLY.
   *         Optional, default: SPI_TRANSMITRECEIVE.
-  * @return bytes received from the slave in 16 bits format.
+  * @return frame received from the slave.
   */
 uint16_t SPIClass::transfer16(uint16_t data, bool skipReceive)
 {
-  uint16_t tmp;
-
-  if (_spiSettings.bitOrder) {
-    tmp = ((data & 0xff00) >> 8) | ((data & 0xff) << 8);
-    data = tmp;
-  }
-  spi_transfer(&_spi, (uint8_t *)&data, (!skipReceive) ? (uint8_t *)&data : NULL, sizeof(uint16_t));
+  spi_transfer_frames(&_spi, &data, (!skipReceive) ? &data : NULL, 1, sizeof(uint16_t));
+  return data;
+}
 
-  if (_spiSettings.bitOrder) {
-    tmp = ((data & 0xff00) >> 8) | ((data & 0xff) << 8);
-    data = tmp;
-  }
+/**
+  * @brief  Transfer several 16-bit frames, in halfword accesses.
+  *         begin() or beginTransaction() must be called at least once before.
+  * @param  tx_buf: array of Tx frames. If NULL, default dummy 0xFFFF frames
+  *                 will be clocked out.
+  * @param  rx_buf: array of Rx frames. If NULL, the received data will be
+  *                 discarded. Can be the same as tx_buf.
+  * @param  count: number of frames to send/receive.
+  */
+void SPIClass::transfer16(const uint16_t *tx_buf, uint16_t *rx_buf, size_t count)
+{
+  spi_transfer_frames(&_spi, tx_buf, rx_buf, count, sizeof(uint16_t));
+}
 
+/**
+  * @brief  Transfer a 32-bit frame on the SPI bus. If the SPI instance
+  *         does not support 32-bit frames, two 16-bit frames are sent, the
+  *         most significant one first in MSB first order.
+  *         begin() or beginTransaction() must be called at least once before.
+  * @param  data: frame to send.
+  * @param  skipReceive: skip receiving data after transmit or not.
+  *         SPI_TRANSMITRECEIVE or SPI_TRANSMITONLY.
+  *         Optional, default: SPI_TRANSMITRECEIVE.
+  * @return frame received from the slave.
+  */
+uint32_t SPIClass::transfer32(uint32_t data, bool skipReceive)
+{
+  spi_transfer_frames(&_spi, &data, (!skipReceive) ? &data : NULL, 1, sizeof(uint32_t));
   return data;
 }
 
+/**
+  * @brief  Transfer several 32-bit frames, in word accesses.
+  *         begin() or beginTransaction() must be called at least once before.
+  * @param  tx_buf: array of Tx frames. If NULL, default dummy 0xFFFFFFFF
+  *                 frames will be clocked out.
+  * @param  rx_buf: array of Rx frames. If NULL, the received data will be
+  *                 discarded. Can be the same as tx_buf.
+  * @param  count: number of frames to send/receive.
+  */
+void SPIClass::transfer32(const uint32_t *tx_buf, uint32_t *rx_buf, size_t count)
+{
+  spi_transfer_frames(&_spi, tx_buf, rx_buf, count, sizeof(uint32_t));
+}
+
 /**
   * @brief  Transfer several bytes. Only one buffer used to send and receive data.
   *         begin() or beginTransaction() must be called at least once before.
@@ -227,6 +371,72 @@ void SPIClass::transfer(const void *tx_buf, void *rx_buf, size_t count)
 }
 
 
+/**
+  * @brief  Start a transfer and return without waiting for its end.
+  *         With DMA, the transfer runs in background and the callback is
+  *         called from the DMA interrupt. Otherwise, the transfer is done
+  *         before returning (or after the callback returning, when started
+  *         from it). The callback can start the next transfer.
+  *         From an interrupt, the DMA is used whatever the length, and the
+  *         transfer fails if it cannot be.
+  *         begin() or beginTransaction() must be called at least once before.
+  * @param  tx_buf: array of Tx bytes, kept until the end of the transfer.
+  *                 If NULL, default dummy 0xFF bytes will be clocked out.
+  * @param  rx_buf: array of Rx bytes filled until the end of the transfer.
+  *                 If NULL, the received data will be discarded.
+  * @param  count: number of bytes to send/receive.
+  * @param  callback: function called at the end of the transfer (optional).
+  * @return true if the transfer is started, false if one is on-going or
+  *         it cannot be done from an interrupt.
+  */
+bool SPIClass::transferAsync(const void *tx_buf, void *rx_buf, size_t count, void (*callback)(void))
+{
+  if (callback == NULL) {
+    return transferAsync(tx_buf, rx_buf, count, NULL, NULL);
+  }
+  if (isBusy()) {
+    return false;
+  }
+  _asyncCallback = callback;
+  return transferAsync(tx_buf, rx_buf, count, asyncComplete, this);
+}
+
+/**
+  * @brief  Same as above, with a callback taking an argument.
+  * @param  tx_buf: array of Tx bytes, kept until the end of the transfer.
+  * @param  rx_buf: array of Rx bytes filled until the end of the transfer.
+  * @param  count: number of bytes to send/receive.
+  * @param  callback: function called at the end of the transfer, can be NULL.
+  * @param  arg: argument given to the callback.
+  * @return true if the transfer is started, false if one is on-going or
+  *         it cannot be done from an interrupt.
+  */
+bool SPIClass::transferAsync(const void *tx_buf, void *rx_buf, size_t count,
+                             void (*callback)(void *arg), void *arg)
+{
+  return (spi_transfer_async(&_spi, ((const uint8_t *)tx_buf), ((uint8_t *)rx_buf),
+                             count, callback, arg) == SPI_OK);
+}
+
+/**
+  * @brief  End of an asynchronous transfer started with a callback without
+  *         argument.
+  * @param  arg: SPIClass instance.
+  */
+void SPIClass::asyncComplete(void *arg)
+{
+  ((SPIClass *)arg)->_asyncCallback();
+}
+
+/**
+  * @brief  Wait for the end of the asynchronous transfer.
+  * @return true if the last asynchronous transfer succeeded.
+  */
+bool SPIClass::waitForCompletion(void)
+{
+  return (spi_transfer_wait(&_spi) == SPI_OK);
+}
+
 /**
   * @brief  Not implemented.
   */
@@ -41,6 +41,14 @@ extern "C" {
 #define SPI_TRANSMITRECEIVE false
 #define SPI_TRANSMITONLY true
 
+// Defines the number of SPISettings resolved into register values by each
+// SPI instance: switching between them only rewrites the SPI configuration
+#ifndef SPI_SETTINGS_CACHE_SIZE
+#define SPI_SETTINGS_CACHE_SIZE 4
+#elif SPI_SETTINGS_CACHE_SIZE <= 0
+#error "SPI_SETTINGS_CACHE_SIZE cannot be less or equal to 0!"
+#endif
+
 class SPISettings {
   public:
     constexpr SPISettings(uint32_t clock, BitOrder bitOrder, uint8_t dataMode)
@@ -122,9 +130,51 @@ class SPIClass {
       _spi.pin_ssel = (ssel);
     };
 
+#if defined(SPI_DMA_ENABLED)
+    // Use DMA for the transfers of at least SPI_DMA_THRESHOLD bytes, shorter
+    // ones are polled. TX channel is required, RX channel is needed to
+    // receive data with DMA.
+    // request is the DMA request (or stream channel), unused on series with
+    // fixed DMA mapping. This needs to be done before the call to begin()
+    void setTxDMA(dma_channel_t *instance, uint32_t request = 0)
+    {
+      _spi.dma_tx = instance;
+      _spi.dma_tx_request = request;
+    };
+    void setRxDMA(dma_channel_t *instance, uint32_t request = 0)
+    {
+      _spi.dma_rx = instance;
+      _spi.dma_rx_request = request;
+    };
+    // Minimum size in bytes of the DMA transfers, 0 to disable the DMA
+    void setDMAThreshold(uint16_t threshold)
+    {
+      _spi.dma_threshold = threshold;
+    };
+#endif
+
     void begin(void);
     void end(void);
 
+#if defined(SPI_DMA_ENABLED)
+    /* Slave mode, instead of begin(): the host selects the SPI with the ssel
+     * pin, which frames the transfers. Each frame is received by DMA in one
+     * of the two buffers in turn, the callback being called on the ssel
+     * rising edge with the buffer and the number of bytes received. The
+     * next frame is received in the other buffer meanwhile. The clock of
+     * the settings is not used. Both DMA channels must be set before.
+     */
+    bool beginSlave(SPISettings settings, uint8_t *rx_buf0, uint8_t *rx_buf1, uint16_t size,
+                    void (*callback)(void *arg, uint8_t *rx_buf, uint16_t count),
+                    void *arg = NULL);
+    // Response sent from the next frame on, and for each frame till another
+    // one is set. tx_buf must be kept meanwhile.
+    void setSlaveResponse(const void *tx_buf, uint16_t count)
+    {
+      spi_slave_set_response(&_spi, (const uint8_t *)tx_buf, count);
+    };
+#endif
+
     /* This function should be used to configure the SPI instance in case you
      * don't use default parameters.
      */
@@ -136,13 +186,36 @@ class SPIClass {
      */
     uint8_t transfer(uint8_t data, bool skipReceive = SPI_TRANSMITRECEIVE);
     uint16_t transfer16(uint16_t data, bool skipReceive = SPI_TRANSMITRECEIVE);
+    uint32_t transfer32(uint32_t data, bool skipReceive = SPI_TRANSMITRECEIVE);
     void transfer(void *buf, size_t count, bool skipReceive = SPI_TRANSMITRECEIVE);
 
+    /* Transfer of 16-bit or 32-bit frames, without byte swapping.
+     * tx_buf and rx_buf can be the same buffer.
+     */
+    void transfer16(const uint16_t *tx_buf, uint16_t *rx_buf, size_t count);
+    void transfer32(const uint32_t *tx_buf, uint32_t *rx_buf, size_t count);
+
     /* Expand SPI API
      * https://github.com/arduino/ArduinoCore-API/discussions/189
      */
     void transfer(const void *tx_buf, void *rx_buf, size_t count);
 
+    /* Asynchronous transfer: uses the DMA if enabled, else it is polled.
+     * A transfer started from an interrupt is never polled: it fails if the
+     * DMA cannot be used.
+     * Buffers must be kept until the end of the transfer, which can be
+     * checked with isBusy() or waited with waitForCompletion().
+     */
+    bool transferAsync(const void *tx_buf, void *rx_buf, size_t count,
+                       void (*callback)(void) = NULL);
+    bool transferAsync(const void *tx_buf, void *rx_buf, size_t count,
+                       void (*callback)(void *arg), void *arg);
+    bool isBusy(void)
+    {
+      return _spi.async_busy;
+    };
+    bool waitForCompletion(void);
+
     /* These methods are deprecated and kept for compatibility.
      * Use SPISettings with SPI.beginTransaction() to configure SPI parameters.
      */
@@ -170,6 +243,21 @@ class SPIClass {
   private:
     /* Current SPISettings */
     SPISettings   _spiSettings = SPISettings();
+
+    /* SPISettings already resolved into register values */
+    struct CachedSettings {
+      SPISettings  settings;
+      spi_config_t config;
+    };
+    CachedSettings _settingsCache[SPI_SETTINGS_CACHE_SIZE];
+    uint8_t       _settingsCount = 0;
+    uint8_t       _settingsNext = 0;
+
+    void applySettings(void);
+
+    /* Callback without argument of the current asynchronous transfer */
+    void (*_asyncCallback)(void) = NULL;
+    static void asyncComplete(void *arg);
 };
 
 extern SPIClass SPI;
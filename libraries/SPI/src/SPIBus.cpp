@@ -0,0 +1,195 @@
+/*
+ * SPI bus manager for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "SPIBus.h"
+
+/**
+  * @brief  Device on an SPI bus.
+  * @param  settings: SPI settings(clock speed, bit order, data mode).
+  * @param  cs: chip select pin (optional). Accepted format: number or
+  *         Arduino format (Dx) or ST format (Pxy). By default, the SPI ssel
+  *         pin is used.
+  */
+SPIDevice::SPIDevice(SPISettings settings, uint32_t cs)
+  : _settings(settings),
+    _csPin(cs),
+    _cs(digitalPinToPinName(cs))
+{
+}
+
+/**
+  * @brief  Configure the chip select pin, set high.
+  */
+void SPIDevice::begin(void)
+{
+  if (_cs != NC) {
+    digitalWriteFast(_cs, HIGH);
+    pinMode(_csPin, OUTPUT);
+  }
+}
+
+/**
+  * @brief  Bus manager of an SPI instance.
+  * @param  spi: SPI instance, begin() must be called before queuing.
+  */
+SPIBus::SPIBus(SPIClass &spi)
+  : _spi(spi)
+{
+}
+
+/**
+  * @brief  Queue a transaction, started at once if the bus is idle.
+  *         The chip select is asserted from the command to the end of data.
+  * @param  device: device to select.
+  * @param  cmd: array of command bytes, sent first. Can be NULL.
+  * @param  cmd_count: number of command bytes.
+  * @param  tx_buf: array of Tx bytes sent after the command.
+  *                 If NULL, default dummy 0xFF bytes will be clocked out.
+  * @param  rx_buf: array of Rx bytes received after the command.
+  *                 If NULL, the received data will be discarded.
+  * @param  count: number of bytes to send/receive after the command.
+  * @param  callback: function called at the end of the transaction (optional).
+  * @param  arg: argument given to the callback.
+  * @return true if queued, false if the queue is full or nothing is to send.
+  */
+bool SPIBus::queueCommand(SPIDevice &device, const void *cmd, size_t cmd_count,
+                          const void *tx_buf, void *rx_buf, size_t count,
+                          SPIBusCallback callback, void *arg)
+{
+  uint32_t primask;
+  uint16_t next;
+  bool idle;
+
+  if (((cmd_count == 0) && (count == 0)) || (cmd_count > UINT16_MAX) || (count > UINT16_MAX)) {
+    return false;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  next = (_head + 1) % (SPI_BUS_QUEUE_SIZE + 1);
+  if (next == _tail) {
+    __set_PRIMASK(primask);
+    return false;
+  }
+  _queue[_head].device = &device;
+  _queue[_head].cmd = cmd;
+  _queue[_head].cmdCount = (cmd == NULL) ? 0 : cmd_count;
+  _queue[_head].tx = tx_buf;
+  _queue[_head].rx = rx_buf;
+  _queue[_head].count = count;
+  _queue[_head].callback = callback;
+  _queue[_head].arg = arg;
+  _head = next;
+  idle = !_active;
+  _active = true;
+  __set_PRIMASK(primask);
+
+  if (idle) {
+    start();
+  }
+  return true;
+}
+
+/**
+  * @brief  Number of transactions queued, including the running one.
+  */
+size_t SPIBus::pending(void)
+{
+  uint16_t head = _head;
+  uint16_t tail = _tail;
+
+  return (head >= tail) ? (head - tail) : (SPI_BUS_QUEUE_SIZE + 1 + head - tail);
+}
+
+/**
+  * @brief  Wait for the end of all the queued transactions.
+  */
+void SPIBus::flush(void)
+{
+  while (_active);
+}
+
+/**
+  * @brief  Start the transaction at the queue tail: switch to the device
+  *         settings, select it and send the command, or the data without it.
+  */
+void SPIBus::start(void)
+{
+  Transaction *transaction = &_queue[_tail];
+  SPIDevice *device = transaction->device;
+  bool started;
+
+  _spi.beginTransaction(device->_settings);
+  if (device->_cs != NC) {
+    digitalWriteFast(device->_cs, LOW);
+  }
+  _dataPhase = (transaction->cmdCount == 0);
+  if (_dataPhase) {
+    started = _spi.transferAsync(transaction->tx, transaction->rx, transaction->count,
+                                 complete, this);
+  } else {
+    started = _spi.transferAsync(transaction->cmd, NULL, transaction->cmdCount,
+                                 complete, this);
+  }
+  if (!started) {
+    finish(false);
+  }
+}
+
+/**
+  * @brief  End the transaction at the queue tail. The next one is started
+  *         before calling the callback, so that the bus is not left idle.
+  * @param  success: false if the transaction failed.
+  */
+void SPIBus::finish(bool success)
+{
+  /* The slot can be reused by the callback */
+  Transaction transaction = _queue[_tail];
+  uint32_t primask;
+  bool more;
+
+  if (transaction.device->_cs != NC) {
+    digitalWriteFast(transaction.device->_cs, HIGH);
+  }
+  primask = __get_PRIMASK();
+  __disable_irq();
+  _tail = (_tail + 1) % (SPI_BUS_QUEUE_SIZE + 1);
+  more = (_tail != _head);
+  _active = more;
+  __set_PRIMASK(primask);
+
+  if (more) {
+    start();
+  }
+  if (transaction.callback != NULL) {
+    transaction.callback(transaction.arg, success);
+  }
+}
+
+/**
+  * @brief  End of an asynchronous transfer: the data follow the command,
+  *         else the transaction is done.
+  * @param  arg: SPIBus instance.
+  */
+void SPIBus::complete(void *arg)
+{
+  SPIBus *bus = (SPIBus *)arg;
+  Transaction *transaction = &bus->_queue[bus->_tail];
+  bool success = bus->_spi.waitForCompletion();
+
+  if (success && !bus->_dataPhase && (transaction->count != 0)) {
+    bus->_dataPhase = true;
+    if (bus->_spi.transferAsync(transaction->tx, transaction->rx, transaction->count,
+                                complete, bus)) {
+      return;
+    }
+    success = false;
+  }
+  bus->finish(success);
+}
@@ -0,0 +1,99 @@
+/*
+ * SPI bus manager for arduino.
+ * Queues the transactions of several devices sharing an SPI instance and
+ * runs them back to back, each with its own settings and chip select.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _SPIBUS_H_INCLUDED
+#define _SPIBUS_H_INCLUDED
+
+#include "SPI.h"
+
+// Defines the number of transactions which can be queued on a bus
+#ifndef SPI_BUS_QUEUE_SIZE
+#define SPI_BUS_QUEUE_SIZE 8
+#elif (SPI_BUS_QUEUE_SIZE <= 0) || (SPI_BUS_QUEUE_SIZE >= 65535)
+#error "SPI_BUS_QUEUE_SIZE must be between 1 and 65534!"
+#endif
+
+// Function called at the end of a transaction, success is false on error
+typedef void (*SPIBusCallback)(void *arg, bool success);
+
+class SPIDevice {
+  public:
+    // cs: chip select pin driven by the bus, active low. Without it, the chip
+    // select is the SPI ssel pin given to the SPIClass, driven by the SPI.
+    SPIDevice(SPISettings settings, uint32_t cs = PNUM_NOT_DEFINED);
+
+    // Configure the chip select pin, deasserted
+    void begin(void);
+
+  private:
+    SPISettings _settings;
+    uint32_t    _csPin;
+    PinName     _cs;
+
+    friend class SPIBus;
+};
+
+class SPIBus {
+  public:
+    SPIBus(SPIClass &spi = SPI);
+
+    /* Queue a transaction: with DMA, it runs in background and the callback
+     * is called from the DMA interrupt. Otherwise, the queued transactions
+     * are done before returning (or after the callback returning, when
+     * queued from it). Buffers must be kept until the end of the transaction.
+     * The SPI must not be used directly while the bus is not idle.
+     */
+    bool queue(SPIDevice &device, const void *tx_buf, void *rx_buf, size_t count,
+               SPIBusCallback callback = NULL, void *arg = NULL)
+    {
+      return queueCommand(device, NULL, 0, tx_buf, rx_buf, count, callback, arg);
+    }
+    // Same, with command bytes sent first, their received data are discarded
+    bool queueCommand(SPIDevice &device, const void *cmd, size_t cmd_count,
+                      const void *tx_buf, void *rx_buf, size_t count,
+                      SPIBusCallback callback = NULL, void *arg = NULL);
+
+    // Number of transactions queued, including the running one
+    size_t pending(void);
+    bool isIdle(void)
+    {
+      return !_active;
+    }
+    // Wait for the end of all the queued transactions
+    void flush(void);
+
+  private:
+    struct Transaction {
+      SPIDevice      *device;
+      const void     *cmd;
+      uint16_t        cmdCount;
+      uint16_t        count;
+      const void     *tx;
+      void           *rx;
+      SPIBusCallback  callback;
+      void           *arg;
+    };
+
+    SPIClass         &_spi;
+    /* One more slot to tell a full queue from an empty one */
+    Transaction       _queue[SPI_BUS_QUEUE_SIZE + 1];
+    volatile uint16_t _head = 0;
+    volatile uint16_t _tail = 0;
+    volatile bool     _active = false;
+    /* The command of the running transaction is sent */
+    bool              _dataPhase = false;
+
+    void start(void);
+    void finish(bool success);
+    static void complete(void *arg);
+};
+
+#endif /* _SPIBUS_H_INCLUDED */
@@ -177,39 +177,78 @@ uint32_t spi_getClkFreq(spi_t *obj)
   *         See https://github.com/stm32duino/Arduino_Core_STM32/issues/1294
   *         Computed delay is half SPI clock
   * @param  obj : pointer to spi_t structure
+  * @param  baudrate_prescaler : SPI_BAUDRATEPRESCALER_x value
   * @retval Disable delay in microsecondes
   */
-static uint32_t compute_disable_delay(spi_t *obj)
+static uint32_t compute_disable_delay(spi_t *obj, uint32_t baudrate_prescaler)
 {
   uint32_t spi_freq = spi_getClkFreqInst(obj->spi);
   uint32_t disable_delay;
   uint32_t prescaler;
-  SPI_HandleTypeDef *handle = &(obj->handle);
 
-  prescaler = 1 << ((handle->Init.BaudRatePrescaler >> SPI_CFG1_MBR_Pos) + 1);
+  prescaler = 1 << ((baudrate_prescaler >> SPI_CFG1_MBR_Pos) + 1);
   disable_delay = (((prescaler * 1000000) / spi_freq) / 2) + 1;
   return disable_delay;
 }
 #endif
 
 /**
-  * @brief  SPI initialization function
+  * @brief  Compute the baud rate prescaler giving the highest speed below
+  *         the requested one
   * @param  obj : pointer to spi_t structure
   * @param  speed : spi output speed
+  * @retval SPI_BAUDRATEPRESCALER_x value
+  */
+static uint32_t spi_get_prescaler(spi_t *obj, uint32_t speed)
+{
+  uint32_t spi_freq = spi_getClkFreqInst(obj->spi);
+  uint32_t prescaler;
+
+  /* For SUBGHZSPI,  'SPI_BAUDRATEPRESCALER_*' == 'SUBGHZSPI_BAUDRATEPRESCALER_*' */
+  if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV2_MHZ)) {
+    prescaler = SPI_BAUDRATEPRESCALER_2;
+  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV4_MHZ)) {
+    prescaler = SPI_BAUDRATEPRESCALER_4;
+  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV8_MHZ)) {
+    prescaler = SPI_BAUDRATEPRESCALER_8;
+  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV16_MHZ)) {
+    prescaler = SPI_BAUDRATEPRESCALER_16;
+  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV32_MHZ)) {
+    prescaler = SPI_BAUDRATEPRESCALER_32;
+  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV64_MHZ)) {
+    prescaler = SPI_BAUDRATEPRESCALER_64;
+  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV128_MHZ)) {
+    prescaler = SPI_BAUDRATEPRESCALER_128;
+  } else {
+    /*
+     * As it is not possible to go below (spi_freq / SPI_SPEED_CLOCK_DIV256_MHZ).
+     * Set prescaler at max value so get the lowest frequency possible.
+     */
+    prescaler = SPI_BAUDRATEPRESCALER_256;
+  }
+  return prescaler;
+}
+
+/**
+  * @brief  SPI initialization, as master or slave
+  * @param  obj : pointer to spi_t structure
+  * @param  speed : spi output speed, unused in slave mode
   * @param  mode : one of the spi modes
   * @param  msb : set to 1 in msb first
+  * @param  slave : true for slave mode, selected by the ssel pin
   * @retval None
   */
-void spi_init(spi_t *obj, uint32_t speed, SPIMode mode, uint8_t msb)
+static void spi_configure(spi_t *obj, uint32_t speed, SPIMode mode, uint8_t msb, bool slave)
 {
   if (obj == NULL) {
     return;
   }
 
   SPI_HandleTypeDef *handle = &(obj->handle);
-  uint32_t spi_freq = 0;
   uint32_t pull = 0;
 
+  spi_transfer_wait(obj);
+
 #if defined(SUBGHZSPI_BASE)
   if (obj->spi != SUBGHZSPI) {
 #endif
@@ -246,42 +285,20 @@ void spi_init(spi_t *obj, uint32_t speed, SPIMode mode, uint8_t msb)
 
   // Configure the SPI pins
   if (obj->pin_ssel != NC) {
-    handle->Init.NSS = SPI_NSS_HARD_OUTPUT;
+    handle->Init.NSS = slave ? SPI_NSS_HARD_INPUT : SPI_NSS_HARD_OUTPUT;
   } else {
     handle->Init.NSS = SPI_NSS_SOFT;
   }
 
   /* Fill default value */
   handle->Instance               = obj->spi;
-  handle->Init.Mode              = SPI_MODE_MASTER;
+  handle->Init.Mode              = slave ? SPI_MODE_SLAVE : SPI_MODE_MASTER;
 
-  spi_freq = spi_getClkFreqInst(obj->spi);
-  /* For SUBGHZSPI,  'SPI_BAUDRATEPRESCALER_*' == 'SUBGHZSPI_BAUDRATEPRESCALER_*' */
-  if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV2_MHZ)) {
-    handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_2;
-  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV4_MHZ)) {
-    handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_4;
-  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV8_MHZ)) {
-    handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_8;
-  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV16_MHZ)) {
-    handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
-  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV32_MHZ)) {
-    handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_32;
-  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV64_MHZ)) {
-    handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_64;
-  } else if (speed >= (spi_freq / SPI_SPEED_CLOCK_DIV128_MHZ)) {
-    handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_128;
-  } else {
-    /*
-     * As it is not possible to go below (spi_freq / SPI_SPEED_CLOCK_DIV256_MHZ).
-     * Set prescaler at max value so get the lowest frequency possible.
-     */
-    handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256;
-  }
+  handle->Init.BaudRatePrescaler = spi_get_prescaler(obj, speed);
 
 #if defined(SPI_IFCR_EOTC)
   // Compute disable delay as baudrate has been modified
-  obj->disable_delay = compute_disable_delay(obj);
+  obj->disable_delay = compute_disable_delay(obj, handle->Init.BaudRatePrescaler);
 #endif
 
   handle->Init.Direction         = SPI_DIRECTION_2LINES;
@@ -396,6 +413,104 @@ void spi_init(spi_t *obj, uint32_t speed, SPIMode mode, uint8_t msb)
   __HAL_SPI_ENABLE(handle);
 }
 
+/**
+  * @brief  SPI initialization function
+  * @param  obj : pointer to spi_t structure
+  * @param  speed : spi output speed
+  * @param  mode : one of the spi modes
+  * @param  msb : set to 1 in msb first
+  * @retval None
+  */
+void spi_init(spi_t *obj, uint32_t speed, SPIMode mode, uint8_t msb)
+{
+  spi_configure(obj, speed, mode, msb, false);
+}
+
+/**
+  * @brief  Resolve SPI settings into register values, starting from the
+  *         current configuration of the initialized SPI
+  * @param  obj : pointer to spi_t structure
+  * @param  speed : spi output speed
+  * @param  mode : one of the spi modes
+  * @param  msb : set to 1 in msb first
+  * @param  config : register values to fill
+  * @retval None
+  */
+void spi_get_config(spi_t *obj, uint32_t speed, SPIMode mode, uint8_t msb, spi_config_t *config)
+{
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+  uint32_t prescaler = spi_get_prescaler(obj, speed);
+  /* 'SPI_POLARITY_*', 'SPI_PHASE_*' and 'SPI_FIRSTBIT_*' are the register bits */
+  uint32_t settings = (((mode == SPI_MODE0) || (mode == SPI_MODE2)) ? SPI_PHASE_1EDGE : SPI_PHASE_2EDGE) |
+                      (((mode == SPI_MODE0) || (mode == SPI_MODE1)) ? SPI_POLARITY_LOW : SPI_POLARITY_HIGH) |
+                      ((msb == 0) ? SPI_FIRSTBIT_LSB : SPI_FIRSTBIT_MSB);
+
+  /* DMA requests are enabled during a transfer only */
+  spi_transfer_wait(obj);
+#if defined(SPI_CR2_TSIZE)
+  config->cfg1 = (READ_REG(_SPI->CFG1) & ~SPI_CFG1_MBR) | prescaler;
+  /* Full-duplex, the direction is set by each transfer */
+  config->cfg2 = (READ_REG(_SPI->CFG2) & ~(SPI_CFG2_COMM | SPI_CFG2_CPOL | SPI_CFG2_CPHA | SPI_CFG2_LSBFRST)) | settings;
+  config->disable_delay = compute_disable_delay(obj, prescaler);
+#else
+  /* Full-duplex, the direction is set by each transfer */
+  config->cr1 = (READ_REG(_SPI->CR1) & ~(SPI_CR1_SPE | SPI_CR1_BIDIMODE | SPI_CR1_BIDIOE | SPI_CR1_RXONLY |
+                                         SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_LSBFIRST)) |
+                prescaler | settings;
+  config->cr2 = READ_REG(_SPI->CR2);
+#endif
+}
+
+/**
+  * @brief  Apply register values resolved by spi_get_config(): the SPI is
+  *         only disabled while written, without reset nor HAL initialization
+  * @param  obj : pointer to spi_t structure
+  * @param  config : register values to write
+  * @retval None
+  */
+void spi_set_config(spi_t *obj, const spi_config_t *config)
+{
+  SPI_HandleTypeDef *handle = &(obj->handle);
+  SPI_TypeDef *_SPI = handle->Instance;
+  uint32_t polarity;
+
+  spi_transfer_wait(obj);
+  /* Configuration can only be changed while the SPI is disabled */
+  LL_SPI_Disable(_SPI);
+#if defined(SPI_CR2_TSIZE)
+  WRITE_REG(_SPI->CFG1, config->cfg1);
+  WRITE_REG(_SPI->CFG2, config->cfg2);
+  obj->disable_delay = config->disable_delay;
+  handle->Init.BaudRatePrescaler = config->cfg1 & SPI_CFG1_MBR;
+  handle->Init.CLKPhase = config->cfg2 & SPI_CFG2_CPHA;
+  handle->Init.FirstBit = config->cfg2 & SPI_CFG2_LSBFRST;
+  polarity = config->cfg2 & SPI_CFG2_CPOL;
+#else
+  WRITE_REG(_SPI->CR2, config->cr2);
+  WRITE_REG(_SPI->CR1, config->cr1);
+  handle->Init.BaudRatePrescaler = config->cr1 & SPI_CR1_BR;
+  handle->Init.CLKPhase = config->cr1 & SPI_CR1_CPHA;
+  handle->Init.FirstBit = config->cr1 & SPI_CR1_LSBFIRST;
+  polarity = config->cr1 & SPI_CR1_CPOL;
+#endif
+
+  if (handle->Init.CLKPolarity != polarity) {
+    handle->Init.CLKPolarity = polarity;
+#if defined(SUBGHZSPI_BASE)
+    if (handle->Instance != SUBGHZSPI) {
+#endif
+      /* SCK pin pulled according the polarity, as done by spi_init() */
+      pin_PullConfig(get_GPIO_Port(STM_PORT(obj->pin_sclk)), STM_LL_GPIO_PIN(obj->pin_sclk),
+                     (polarity == SPI_POLARITY_LOW) ? GPIO_PULLDOWN : GPIO_PULLUP);
+#if defined(SUBGHZSPI_BASE)
+    }
+#endif
+  }
+
+  /* In order to set correctly the SPI polarity we need to enable the peripheral */
+  LL_SPI_Enable(_SPI);
+}
+
 /**
   * @brief This function is implemented to deinitialize the SPI interface
   *        (IOs + SPI block)
@@ -410,8 +525,22 @@ void spi_deinit(spi_t *obj)
 
   SPI_HandleTypeDef *handle = &(obj->handle);
 
+  spi_transfer_wait(obj);
+#if defined(SPI_DMA_ENABLED)
+  spi_slave_stop(obj);
+#endif
   HAL_SPI_DeInit(handle);
 
+#if defined(SPI_DMA_ENABLED)
+  if (obj->dma_ready & SPI_DMA_TX) {
+    dma_deinit(&(obj->hdma_tx));
+  }
+  if (obj->dma_ready & SPI_DMA_RX) {
+    dma_deinit(&(obj->hdma_rx));
+  }
+  obj->dma_ready = 0;
+#endif
+
 #if defined SPI1_BASE
   // Reset SPI and disable clock
   if (handle->Instance == SPI1) {
@@ -470,79 +599,1000 @@ void spi_deinit(spi_t *obj)
 }
 
 /**
-  * @brief This function is implemented by user to send/receive data over
-  *         SPI interface
+  * @brief  Set the SPI frame size, if not already set
   * @param  obj : pointer to spi_t structure
-  * @param  tx_buffer : tx data to send before reception
-  * @param  rx_buffer : rx data to receive if not numm
-  * @param  len : length in byte of the data to send and receive
-  * @retval status of the send operation (0) in case of error
+  * @param  size : frame size in bytes (1, 2 or 4 if natively supported)
+  * @retval None
   */
-spi_status_e spi_transfer(spi_t *obj, const uint8_t *tx_buffer, uint8_t *rx_buffer,
-                          uint16_t len)
+static void spi_set_frame_size(spi_t *obj, uint8_t size)
 {
-  spi_status_e ret = SPI_OK;
-  uint32_t tickstart, size = len;
   SPI_TypeDef *_SPI = obj->handle.Instance;
-  uint8_t *tx_buf = (uint8_t *)tx_buffer;
+  uint32_t width = (size == 1) ? LL_SPI_DATAWIDTH_8BIT : LL_SPI_DATAWIDTH_16BIT;
 
-  if (len == 0) {
-    ret = SPI_ERROR;
-  } else {
-    tickstart = HAL_GetTick();
+#if defined(SPI_CR2_TSIZE)
+  if (size == 4) {
+    width = LL_SPI_DATAWIDTH_32BIT;
+  }
+#endif
+  if (LL_SPI_GetDataWidth(_SPI) != width) {
+    /* Frame size can only be changed while the SPI is disabled */
+    LL_SPI_Disable(_SPI);
+    LL_SPI_SetDataWidth(_SPI, width);
+#if defined(SPI_CR2_FRXTH)
+    /* RXNE is raised when a frame is received */
+    LL_SPI_SetRxFIFOThreshold(_SPI, (size == 1) ? LL_SPI_RX_FIFO_TH_QUARTER : LL_SPI_RX_FIFO_TH_HALF);
+#endif
+    /* SPI with a transfer size counter is enabled by the next transfer */
+#if !defined(SPI_CR2_TSIZE)
+    LL_SPI_Enable(_SPI);
+#endif
+  }
+}
 
+/* Direction of the transfers without rx buffer: the RX side is disabled */
 #if defined(SPI_CR2_TSIZE)
-    /* Start transfer */
-    LL_SPI_SetTransferSize(_SPI, size);
+#define SPI_DIRECTION_TX_ONLY   LL_SPI_SIMPLEX_TX
+#else
+#define SPI_DIRECTION_TX_ONLY   LL_SPI_HALF_DUPLEX_TX
+#endif
+
+/**
+  * @brief  Set the transfer direction: full-duplex, or transmit-only so that
+  *         nothing is received and no overrun occurs
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_only : true if the received data are not read
+  * @retval None
+  */
+static void spi_set_direction(spi_t *obj, bool tx_only)
+{
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+  uint32_t direction = tx_only ? SPI_DIRECTION_TX_ONLY : LL_SPI_FULL_DUPLEX;
+
+  if (LL_SPI_GetTransferDirection(_SPI) != direction) {
+    /* Direction can only be changed while the SPI is disabled */
+    LL_SPI_Disable(_SPI);
+    LL_SPI_SetTransferDirection(_SPI, direction);
+    if (!tx_only) {
+      /* Received data and overrun left by a previous transfer are dropped */
+#if defined(SPI_SR_FRLVL)
+      while (LL_SPI_GetRxFIFOLevel(_SPI) != LL_SPI_RX_FIFO_EMPTY) {
+        LL_SPI_ReceiveData8(_SPI);
+      }
+#endif
+      LL_SPI_ClearFlag_OVR(_SPI);
+    }
+    /* SPI with a transfer size counter is enabled by the next transfer */
+#if !defined(SPI_CR2_TSIZE)
     LL_SPI_Enable(_SPI);
-    LL_SPI_StartMasterTransfer(_SPI);
 #endif
+  }
+}
 
-    while (size--) {
-#if defined(SPI_SR_TXP)
-      while (!LL_SPI_IsActiveFlag_TXP(_SPI));
+/**
+  * @brief  Check if 32-bit frames are supported by the SPI instance
+  * @param  obj : pointer to spi_t structure
+  * @retval true if supported, else they are sent as two 16-bit frames
+  */
+static bool spi_frame32_supported(spi_t *obj)
+{
+#if defined(IS_SPI_HIGHEND_INSTANCE)
+  return IS_SPI_HIGHEND_INSTANCE(obj->handle.Instance);
+#elif defined(IS_SPI_FULL_INSTANCE)
+  return IS_SPI_FULL_INSTANCE(obj->handle.Instance);
+#else
+  UNUSED(obj);
+  return false;
+#endif
+}
+
+/*
+ * Bytes held by the RX FIFO: frames are sent ahead of the received ones up to
+ * this size, so that a late read never overruns it.
+ */
+#if defined(SPI_CR2_TSIZE)
+#define SPI_RX_FIFO_SIZE        8
+#elif defined(SPI_SR_FRLVL)
+#define SPI_RX_FIFO_SIZE        4
 #else
-      while (!LL_SPI_IsActiveFlag_TXE(_SPI));
+#define SPI_RX_FIFO_SIZE        1
+#endif
+/* Polling loops between two timeout checks */
+#define SPI_TIMEOUT_CHECK_LOOPS 256
+
+/**
+  * @brief  Write a frame in the TX FIFO
+  * @param  _SPI : SPI instance
+  * @param  data : frame to send
+  * @param  size : frame size in bytes (1, 2 or 4)
+  * @retval None
+  */
+static inline void spi_write_frame(SPI_TypeDef *_SPI, uint32_t data, uint8_t size)
+{
+  if (size == 1) {
+    LL_SPI_TransmitData8(_SPI, (uint8_t)data);
+#if defined(SPI_CR2_TSIZE)
+  } else if (size == 4) {
+    LL_SPI_TransmitData32(_SPI, data);
+#endif
+  } else {
+    LL_SPI_TransmitData16(_SPI, (uint16_t)data);
+  }
+}
+
+/**
+  * @brief  Read a frame from the RX FIFO
+  * @param  _SPI : SPI instance
+  * @param  size : frame size in bytes (1, 2 or 4)
+  * @retval frame received
+  */
+static inline uint32_t spi_read_frame(SPI_TypeDef *_SPI, uint8_t size)
+{
+  if (size == 1) {
+    return LL_SPI_ReceiveData8(_SPI);
+#if defined(SPI_CR2_TSIZE)
+  } else if (size == 4) {
+    return LL_SPI_ReceiveData32(_SPI);
 #endif
-      LL_SPI_TransmitData8(_SPI, tx_buf ? *tx_buf++ : 0XFF);
+  }
+  return LL_SPI_ReceiveData16(_SPI);
+}
 
+/**
+  * @brief  Send and receive one 16-bit frame, the SPI must be started
+  * @param  _SPI : SPI instance
+  * @param  data : frame to send
+  * @retval frame received
+  */
+static uint32_t spi_poll_frame16(SPI_TypeDef *_SPI, uint32_t data)
+{
+#if defined(SPI_SR_TXP)
+  while (!LL_SPI_IsActiveFlag_TXP(_SPI));
+#else
+  while (!LL_SPI_IsActiveFlag_TXE(_SPI));
+#endif
+  LL_SPI_TransmitData16(_SPI, (uint16_t)data);
 #if defined(SPI_SR_RXP)
-      while (!LL_SPI_IsActiveFlag_RXP(_SPI));
+  while (!LL_SPI_IsActiveFlag_RXP(_SPI));
+#else
+  while (!LL_SPI_IsActiveFlag_RXNE(_SPI));
+#endif
+  return LL_SPI_ReceiveData16(_SPI);
+}
+
+/**
+  * @brief  Close a polled transfer
+  * @param  obj : pointer to spi_t structure
+  * @param  rx_dropped : true if the received data were not read
+  * @retval None
+  */
+static void spi_close_transfer(spi_t *obj, bool rx_dropped)
+{
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+
+#if defined(SPI_IFCR_EOTC)
+  if (rx_dropped) {
+    while (!LL_SPI_IsActiveFlag_EOT(_SPI));
+  }
+  // Add a delay before disabling SPI otherwise last-bit/last-clock may be truncated
+  // See https://github.com/stm32duino/Arduino_Core_STM32/issues/1294
+  // Computed delay is half SPI clock
+  delayMicroseconds(obj->disable_delay);
+
+  /* Close transfer */
+  /* Clear flags */
+  LL_SPI_ClearFlag_EOT(_SPI);
+  LL_SPI_ClearFlag_TXTF(_SPI);
+  /* Disable SPI peripheral, the rx FIFO is flushed */
+  LL_SPI_Disable(_SPI);
+  if (rx_dropped) {
+    LL_SPI_ClearFlag_OVR(_SPI);
+  }
 #else
-      while (!LL_SPI_IsActiveFlag_RXNE(_SPI));
+  if (rx_dropped) {
+    while (!LL_SPI_IsActiveFlag_TXE(_SPI));
+#if defined(SPI_SR_FTLVL)
+    while (LL_SPI_GetTxFIFOLevel(_SPI) != LL_SPI_TX_FIFO_EMPTY);
+#endif
+  }
+  /* Wait for end of transfer */
+  while (LL_SPI_IsActiveFlag_BSY(_SPI));
+  if (rx_dropped) {
+#if defined(SPI_SR_FRLVL)
+    while (LL_SPI_GetRxFIFOLevel(_SPI) != LL_SPI_RX_FIFO_EMPTY) {
+      LL_SPI_ReceiveData8(_SPI);
+    }
 #endif
-      if (rx_buffer) {
-        *rx_buffer++ = LL_SPI_ReceiveData8(_SPI);
+    LL_SPI_ClearFlag_OVR(_SPI);
+  }
+#endif
+}
+
+/**
+  * @brief  Polled transfer keeping the TX FIFO filled while the RX one is
+  *         drained. Frames are sent ahead of the received ones up to the
+  *         RX FIFO size, so that it cannot overflow whatever the latency.
+  *         Without rx buffer, the SPI is transmit-only.
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : tx frames to send, dummy 0xFF.. if NULL
+  * @param  rx_buffer : rx frames to receive if not NULL
+  * @param  len : number of frames to send and receive
+  * @param  size : frame size in bytes (1, 2 or 4), as set in the SPI
+  * @retval status of the transfer
+  */
+static spi_status_e spi_transfer_poll(spi_t *obj, const uint8_t *tx_buffer,
+                                      uint8_t *rx_buffer, uint16_t len, uint8_t size)
+{
+  spi_status_e ret = SPI_OK;
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+  uint32_t tickstart = HAL_GetTick();
+  uint32_t depth = (SPI_RX_FIFO_SIZE > size) ? (SPI_RX_FIFO_SIZE / size) : 1;
+  bool rx_dropped = (rx_buffer == NULL);
+  uint32_t tx_left = len;
+  uint32_t rx_left = rx_dropped ? 0 : len;
+  uint32_t loops = 0;
+  uint32_t data;
+
+#if defined(SPI_CR2_TSIZE)
+  /* Start transfer */
+  LL_SPI_SetTransferSize(_SPI, len);
+  LL_SPI_Enable(_SPI);
+  LL_SPI_StartMasterTransfer(_SPI);
+#endif
+
+  while ((tx_left != 0) || (rx_left != 0)) {
+#if defined(SPI_SR_TXP)
+    if ((tx_left != 0) && LL_SPI_IsActiveFlag_TXP(_SPI) &&
+#else
+    if ((tx_left != 0) && LL_SPI_IsActiveFlag_TXE(_SPI) &&
+#endif
+        (rx_dropped || ((rx_left - tx_left) < depth))) {
+      if (tx_buffer == NULL) {
+        data = 0xFFFFFFFF;
+      } else if (size == 1) {
+        data = *tx_buffer;
+      } else if (size == 2) {
+        data = *(const uint16_t *)tx_buffer;
       } else {
-        LL_SPI_ReceiveData8(_SPI);
+        data = *(const uint32_t *)tx_buffer;
       }
-      if ((SPI_TRANSFER_TIMEOUT != HAL_MAX_DELAY) &&
-          (HAL_GetTick() - tickstart >= SPI_TRANSFER_TIMEOUT)) {
-        ret = SPI_TIMEOUT;
-        break;
+      spi_write_frame(_SPI, data, size);
+      if (tx_buffer != NULL) {
+        tx_buffer += size;
+      }
+      tx_left--;
+    }
+#if defined(SPI_SR_RXP)
+    if ((rx_left != 0) && LL_SPI_IsActiveFlag_RXP(_SPI)) {
+#else
+    if ((rx_left != 0) && LL_SPI_IsActiveFlag_RXNE(_SPI)) {
+#endif
+      data = spi_read_frame(_SPI, size);
+      if (size == 1) {
+        *rx_buffer = (uint8_t)data;
+      } else if (size == 2) {
+        *(uint16_t *)rx_buffer = (uint16_t)data;
+      } else {
+        *(uint32_t *)rx_buffer = data;
       }
+      rx_buffer += size;
+      rx_left--;
     }
+    /* Timeout is checked by block of loops, not for each frame */
+    if (((++loops % SPI_TIMEOUT_CHECK_LOOPS) == 0) &&
+        (SPI_TRANSFER_TIMEOUT != HAL_MAX_DELAY) &&
+        (HAL_GetTick() - tickstart >= SPI_TRANSFER_TIMEOUT)) {
+      ret = SPI_TIMEOUT;
+      break;
+    }
+  }
+  spi_close_transfer(obj, rx_dropped);
+  return ret;
+}
 
-#if defined(SPI_IFCR_EOTC)
-    // Add a delay before disabling SPI otherwise last-bit/last-clock may be truncated
-    // See https://github.com/stm32duino/Arduino_Core_STM32/issues/1294
-    // Computed delay is half SPI clock
-    delayMicroseconds(obj->disable_delay);
-
-    /* Close transfer */
-    /* Clear flags */
-    LL_SPI_ClearFlag_EOT(_SPI);
-    LL_SPI_ClearFlag_TXTF(_SPI);
-    /* Disable SPI peripheral */
-    LL_SPI_Disable(_SPI);
+/**
+  * @brief  End of an asynchronous transfer: the callback can start the next one
+  * @param  obj : pointer to spi_t structure
+  * @param  status : status of the transfer
+  * @retval None
+  */
+static void spi_async_complete(spi_t *obj, spi_status_e status)
+{
+  void (*callback)(void *arg) = obj->async_callback;
+
+  obj->async_status = status;
+  obj->async_busy = 0;
+  if (callback != NULL) {
+    callback(obj->async_arg);
+  }
+}
+
+#if defined(SPI_DMA_ENABLED)
+/* Dummy data sent when there is no tx buffer */
+static uint32_t spi_dma_dummy_tx = 0xFFFFFFFF;
+
+static void spi_dma_complete(DMA_HandleTypeDef *hdma);
+static void spi_dma_error(DMA_HandleTypeDef *hdma);
+
+/**
+  * @brief  Initialize the DMA channels requested for the transfers.
+  *         The RX channel is only used with a TX channel.
+  * @param  obj : pointer to spi_t structure
+  * @retval None
+  */
+void spi_attach_dma(spi_t *obj)
+{
+  if (obj == NULL) {
+    return;
+  }
+  obj->dma_ready = 0;
+  if ((obj->dma_tx != NULL) &&
+      dma_init(&(obj->hdma_tx), obj->dma_tx, obj->dma_tx_request,
+               DMA_MEMORY_TO_PERIPH, DMA_NORMAL, 1)) {
+    /* Parent is used to get the spi_t structure from the interrupt */
+    obj->hdma_tx.Parent = obj;
+    obj->hdma_tx.XferCpltCallback = spi_dma_complete;
+    obj->hdma_tx.XferErrorCallback = spi_dma_error;
+    obj->dma_ready |= SPI_DMA_TX;
+    if ((obj->dma_rx != NULL) &&
+        dma_init(&(obj->hdma_rx), obj->dma_rx, obj->dma_rx_request,
+                 DMA_PERIPH_TO_MEMORY, DMA_NORMAL, 1)) {
+      obj->hdma_rx.Parent = obj;
+      obj->hdma_rx.XferCpltCallback = spi_dma_complete;
+      obj->hdma_rx.XferErrorCallback = spi_dma_error;
+      obj->dma_ready |= SPI_DMA_RX;
+    }
+  }
+}
+
+/**
+  * @brief  Check if a transfer can be done by DMA
+  * @param  obj : pointer to spi_t structure
+  * @param  rx_buffer : rx buffer, NULL if received data are dropped
+  * @param  len : length in byte of the transfer
+  * @param  any_len : true to ignore the threshold, the transfer must not
+  *         be polled
+  * @retval true if the DMA has to be used
+  */
+static bool spi_dma_usable(spi_t *obj, const void *rx_buffer, uint32_t len, bool any_len)
+{
+  if ((obj->dma_threshold == 0) || (!any_len && (len < obj->dma_threshold)) ||
+      !(obj->dma_ready & SPI_DMA_TX)) {
+    return false;
+  }
+  if (rx_buffer != NULL) {
+    if (!(obj->dma_ready & SPI_DMA_RX)) {
+      return false;
+    }
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    /* Buffer is invalidated from the data cache, it must be aligned on lines */
+    if ((((uint32_t)rx_buffer | len) & (DMA_DCACHE_LINE_SIZE - 1U)) != 0U) {
+      return false;
+    }
+#endif
+  }
+  return true;
+}
+
+/**
+  * @brief  Start a DMA transfer
+  * @note   Without rx buffer, the SPI is transmit-only: the RX channel is
+  *         not used.
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : tx data to send, dummy 0xFF if NULL
+  * @param  rx_buffer : rx data to receive if not NULL
+  * @param  len : number of frames to send and receive
+  * @param  size : frame size in bytes (1, 2 or 4), as set in the SPI
+  * @param  async : true to end the transfer from the DMA interrupt
+  * @retval None
+  */
+static void spi_dma_start(spi_t *obj, const void *tx_buffer, void *rx_buffer,
+                          uint16_t len, uint8_t size, bool async)
+{
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+  bool rx_dma = (rx_buffer != NULL);
+#if defined(SPI_CR2_TSIZE)
+  uint32_t tx_reg = LL_SPI_DMA_GetTxRegAddr(_SPI);
+  uint32_t rx_reg = LL_SPI_DMA_GetRxRegAddr(_SPI);
+#else
+  uint32_t tx_reg = LL_SPI_DMA_GetRegAddr(_SPI);
+  uint32_t rx_reg = tx_reg;
+#endif
+  obj->dma_rx_buffer = rx_buffer;
+  obj->dma_len = len * size;
+
+  /* Dummy data are sent (or received) without incrementing the address */
+  dma_set_data_size(&(obj->hdma_tx), size);
+  dma_set_mem_inc(&(obj->hdma_tx), tx_buffer != NULL);
+  if (tx_buffer != NULL) {
+    dma_clean_dcache(tx_buffer, obj->dma_len);
+  } else {
+    tx_buffer = &spi_dma_dummy_tx;
+    dma_clean_dcache(tx_buffer, sizeof(spi_dma_dummy_tx));
+  }
+  /* The interrupt is raised by the last channel to complete */
+  if (rx_dma) {
+    dma_set_data_size(&(obj->hdma_rx), size);
+    if (async) {
+      HAL_DMA_Start_IT(&(obj->hdma_rx), rx_reg, (uint32_t)rx_buffer, len);
+    } else {
+      HAL_DMA_Start(&(obj->hdma_rx), rx_reg, (uint32_t)rx_buffer, len);
+    }
+    LL_SPI_EnableDMAReq_RX(_SPI);
+  }
+#if defined(SPI_CR2_TSIZE)
+  LL_SPI_SetTransferSize(_SPI, len);
+#endif
+  if (async && !rx_dma) {
+    HAL_DMA_Start_IT(&(obj->hdma_tx), (uint32_t)tx_buffer, tx_reg, len);
+  } else {
+    HAL_DMA_Start(&(obj->hdma_tx), (uint32_t)tx_buffer, tx_reg, len);
+  }
+  LL_SPI_EnableDMAReq_TX(_SPI);
+#if defined(SPI_CR2_TSIZE)
+  LL_SPI_Enable(_SPI);
+  LL_SPI_StartMasterTransfer(_SPI);
+#endif
+}
+
+/**
+  * @brief  End a DMA transfer once its channels are done (or aborted)
+  * @param  obj : pointer to spi_t structure
+  * @param  ret : status of the DMA transfer
+  * @retval status of the transfer
+  */
+static spi_status_e spi_dma_end(spi_t *obj, spi_status_e ret)
+{
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+#if defined(SPI_CR2_TSIZE)
+  uint32_t tickstart = HAL_GetTick();
+
+  while ((ret == SPI_OK) && !LL_SPI_IsActiveFlag_EOT(_SPI)) {
+    if ((SPI_TRANSFER_TIMEOUT != HAL_MAX_DELAY) &&
+        (HAL_GetTick() - tickstart >= SPI_TRANSFER_TIMEOUT)) {
+      ret = SPI_TIMEOUT;
+    }
+  }
+  // Add a delay before disabling SPI otherwise last-bit/last-clock may be truncated
+  // See https://github.com/stm32duino/Arduino_Core_STM32/issues/1294
+  delayMicroseconds(obj->disable_delay);
+
+  /* Close transfer */
+  LL_SPI_ClearFlag_EOT(_SPI);
+  LL_SPI_ClearFlag_TXTF(_SPI);
+  /* Disable SPI peripheral, the rx FIFO is flushed */
+  LL_SPI_Disable(_SPI);
+  LL_SPI_DisableDMAReq_TX(_SPI);
+  LL_SPI_DisableDMAReq_RX(_SPI);
+  LL_SPI_ClearFlag_OVR(_SPI);
+#else
+  /* Wait for end of transfer */
+  while (!LL_SPI_IsActiveFlag_TXE(_SPI));
+#if defined(SPI_SR_FTLVL)
+  while (LL_SPI_GetTxFIFOLevel(_SPI) != LL_SPI_TX_FIFO_EMPTY);
+#endif
+  while (LL_SPI_IsActiveFlag_BSY(_SPI));
+  LL_SPI_DisableDMAReq_TX(_SPI);
+  LL_SPI_DisableDMAReq_RX(_SPI);
+#endif
+
+  if (obj->dma_rx_buffer != NULL) {
+    dma_invalidate_dcache(obj->dma_rx_buffer, obj->dma_len);
+  }
+  return ret;
+}
+
+/**
+  * @brief  Send/receive data over SPI interface using the DMA
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : tx data to send, dummy 0xFF if NULL
+  * @param  rx_buffer : rx data to receive if not NULL
+  * @param  len : number of frames to send and receive
+  * @param  size : frame size in bytes (1, 2 or 4), as set in the SPI
+  * @retval status of the transfer
+  */
+static spi_status_e spi_transfer_dma(spi_t *obj, const void *tx_buffer,
+                                     void *rx_buffer, uint16_t len, uint8_t size)
+{
+  spi_status_e ret = SPI_OK;
+  bool rx_dma = (rx_buffer != NULL);
+
+  spi_dma_start(obj, tx_buffer, rx_buffer, len, size, false);
+
+  /* Last data received (or sent) */
+  if ((HAL_DMA_PollForTransfer(&(obj->hdma_tx), HAL_DMA_FULL_TRANSFER,
+                               SPI_TRANSFER_TIMEOUT) != HAL_OK) ||
+      (rx_dma && (HAL_DMA_PollForTransfer(&(obj->hdma_rx), HAL_DMA_FULL_TRANSFER,
+                                          SPI_TRANSFER_TIMEOUT) != HAL_OK))) {
+    HAL_DMA_Abort(&(obj->hdma_tx));
+    if (rx_dma) {
+      HAL_DMA_Abort(&(obj->hdma_rx));
+    }
+    ret = SPI_TIMEOUT;
+  }
+  return spi_dma_end(obj, ret);
+}
+
+/**
+  * @brief  DMA transfer complete callback of an asynchronous transfer
+  * @param  hdma : DMA handle of the last channel to complete
+  * @retval None
+  */
+static void spi_dma_complete(DMA_HandleTypeDef *hdma)
+{
+  spi_t *obj = (spi_t *)hdma->Parent;
+
+  if (hdma == &(obj->hdma_rx)) {
+    /* TX channel is already done, only release it */
+    HAL_DMA_PollForTransfer(&(obj->hdma_tx), HAL_DMA_FULL_TRANSFER, 0);
+  }
+  spi_async_complete(obj, spi_dma_end(obj, SPI_OK));
+}
+
+/**
+  * @brief  DMA error callback of an asynchronous transfer
+  * @param  hdma : DMA handle
+  * @retval None
+  */
+static void spi_dma_error(DMA_HandleTypeDef *hdma)
+{
+  spi_t *obj = (spi_t *)hdma->Parent;
+
+  HAL_DMA_Abort(&(obj->hdma_tx));
+  if (obj->dma_rx_buffer != NULL) {
+    HAL_DMA_Abort(&(obj->hdma_rx));
+  }
+  spi_async_complete(obj, spi_dma_end(obj, SPI_ERROR));
+}
+
+#if !defined(SPI_CR2_TSIZE)
+/**
+  * @brief  Reset the SPI keeping its configuration: the only way to flush
+  *         the data already loaded for transmission
+  * @param  obj : pointer to spi_t structure
+  * @retval None
+  */
+static void spi_slave_flush(spi_t *obj)
+{
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+  uint32_t cr1 = READ_REG(_SPI->CR1) & ~SPI_CR1_SPE;
+  uint32_t cr2 = READ_REG(_SPI->CR2) & ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+
+#if defined SPI1_BASE
+  if (_SPI == SPI1) {
+    __HAL_RCC_SPI1_FORCE_RESET();
+    __HAL_RCC_SPI1_RELEASE_RESET();
+  }
+#endif
+#if defined SPI2_BASE
+  if (_SPI == SPI2) {
+    __HAL_RCC_SPI2_FORCE_RESET();
+    __HAL_RCC_SPI2_RELEASE_RESET();
+  }
+#endif
+#if defined SPI3_BASE
+  if (_SPI == SPI3) {
+    __HAL_RCC_SPI3_FORCE_RESET();
+    __HAL_RCC_SPI3_RELEASE_RESET();
+  }
+#endif
+#if defined SPI4_BASE
+  if (_SPI == SPI4) {
+    __HAL_RCC_SPI4_FORCE_RESET();
+    __HAL_RCC_SPI4_RELEASE_RESET();
+  }
+#endif
+#if defined SPI5_BASE
+  if (_SPI == SPI5) {
+    __HAL_RCC_SPI5_FORCE_RESET();
+    __HAL_RCC_SPI5_RELEASE_RESET();
+  }
+#endif
+#if defined SPI6_BASE
+  if (_SPI == SPI6) {
+    __HAL_RCC_SPI6_FORCE_RESET();
+    __HAL_RCC_SPI6_RELEASE_RESET();
+  }
+#endif
+  WRITE_REG(_SPI->CR2, cr2);
+  WRITE_REG(_SPI->CR1, cr1);
+}
+#endif
+
+/**
+  * @brief  Prepare the DMA channels for the next frame of the slave mode
+  * @param  obj : pointer to spi_t structure
+  * @retval None
+  */
+static void spi_slave_arm(spi_t *obj)
+{
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+#if defined(SPI_CR2_TSIZE)
+  uint32_t tx_reg = LL_SPI_DMA_GetTxRegAddr(_SPI);
+  uint32_t rx_reg = LL_SPI_DMA_GetRxRegAddr(_SPI);
+#else
+  uint32_t tx_reg = LL_SPI_DMA_GetRegAddr(_SPI);
+  uint32_t rx_reg = tx_reg;
+#endif
+  const void *tx_buffer = obj->slave_tx;
+  uint16_t tx_len = obj->slave_tx_len;
+
+  /* Data left by the previous frame are dropped */
+#if defined(SPI_CR2_TSIZE)
+  LL_SPI_Disable(_SPI);
+  LL_SPI_ClearFlag_OVR(_SPI);
+  LL_SPI_ClearFlag_UDR(_SPI);
+  LL_SPI_ClearFlag_EOT(_SPI);
+  LL_SPI_ClearFlag_TXTF(_SPI);
+  /* Endless transfer, framed by NSS */
+  LL_SPI_SetTransferSize(_SPI, 0);
+#else
+  spi_slave_flush(obj);
+#endif
+
+  /* Without response, dummy data are sent */
+  dma_set_mem_inc(&(obj->hdma_tx), tx_buffer != NULL);
+  if (tx_buffer != NULL) {
+    dma_clean_dcache(tx_buffer, tx_len);
+  } else {
+    tx_buffer = &spi_dma_dummy_tx;
+    tx_len = obj->slave_rx_size;
+  }
+  dma_set_data_size(&(obj->hdma_tx), 1);
+  dma_set_data_size(&(obj->hdma_rx), 1);
+  HAL_DMA_Start(&(obj->hdma_rx), rx_reg, (uint32_t)obj->slave_rx[obj->slave_rx_index],
+                obj->slave_rx_size);
+  LL_SPI_EnableDMAReq_RX(_SPI);
+  HAL_DMA_Start(&(obj->hdma_tx), (uint32_t)tx_buffer, tx_reg, tx_len);
+  LL_SPI_EnableDMAReq_TX(_SPI);
+  LL_SPI_Enable(_SPI);
+}
+
+/**
+  * @brief  Stop the DMA channels of the slave mode
+  * @param  obj : pointer to spi_t structure
+  * @retval None
+  */
+static void spi_slave_disarm(spi_t *obj)
+{
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+
+  HAL_DMA_Abort(&(obj->hdma_rx));
+  HAL_DMA_Abort(&(obj->hdma_tx));
+  LL_SPI_DisableDMAReq_TX(_SPI);
+  LL_SPI_DisableDMAReq_RX(_SPI);
+}
+
+/**
+  * @brief  SPI slave initialization: the SPI is selected by the host
+  *         through the ssel pin, which frames the transfers
+  * @param  obj : pointer to spi_t structure
+  * @param  mode : one of the spi modes
+  * @param  msb : set to 1 in msb first
+  * @retval SPI_OK, SPI_ERROR without ssel pin or on failure
+  */
+spi_status_e spi_slave_init(spi_t *obj, SPIMode mode, uint8_t msb)
+{
+  if ((obj == NULL) || (obj->pin_ssel == NC)) {
+    return SPI_ERROR;
+  }
+  obj->slave_active = 0;
+  obj->handle.State = HAL_SPI_STATE_RESET;
+  spi_configure(obj, 0, mode, msb, true);
+  if (obj->handle.State == HAL_SPI_STATE_RESET) {
+    return SPI_ERROR;
+  }
+  /* Enabled once the DMA is ready */
+  LL_SPI_Disable(obj->handle.Instance);
+  return SPI_OK;
+}
+
+/**
+  * @brief  Start the slave mode: the frames are received by DMA, in the two
+  *         buffers in turn, and the response is sent at the same time.
+  *         spi_slave_frame_end() must be called on the ssel rising edge.
+  * @param  obj : pointer to spi_t structure
+  * @param  rx_buffer0 : first buffer of the received frames
+  * @param  rx_buffer1 : second buffer of the received frames
+  * @param  size : size in bytes of each buffer, the longest frame
+  * @param  callback : function called at the end of each frame, with the
+  *         buffer and the number of bytes received
+  * @param  arg : argument given to the callback
+  * @note   On Cortex-M7, the buffers must be aligned on the cache lines.
+  * @retval SPI_OK, SPI_ERROR without DMA channels
+  */
+spi_status_e spi_slave_start(spi_t *obj, uint8_t *rx_buffer0, uint8_t *rx_buffer1, uint16_t size,
+                             void (*callback)(void *arg, uint8_t *rx_buffer, uint16_t len), void *arg)
+{
+  if ((obj == NULL) || (rx_buffer0 == NULL) || (rx_buffer1 == NULL) || (size == 0) ||
+      ((obj->dma_ready & (SPI_DMA_TX | SPI_DMA_RX)) != (SPI_DMA_TX | SPI_DMA_RX))) {
+    return SPI_ERROR;
+  }
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  /* Buffers are invalidated from the data cache, they must be aligned on lines */
+  if ((((uint32_t)rx_buffer0 | (uint32_t)rx_buffer1 | size) & (DMA_DCACHE_LINE_SIZE - 1U)) != 0U) {
+    return SPI_ERROR;
+  }
+#endif
+  spi_slave_stop(obj);
+  obj->slave_rx[0] = rx_buffer0;
+  obj->slave_rx[1] = rx_buffer1;
+  obj->slave_rx_size = size;
+  obj->slave_rx_index = 0;
+  obj->slave_callback = callback;
+  obj->slave_arg = arg;
+  if (obj->slave_tx_pending) {
+    obj->slave_tx_pending = 0;
+    obj->slave_tx = obj->slave_tx_next;
+    obj->slave_tx_len = obj->slave_tx_next_len;
+  }
+  /* ssel pin may have been set as input to get its edges */
+  pinmap_pinout(obj->pin_ssel, PinMap_SPI_SSEL);
+  spi_slave_arm(obj);
+  obj->slave_active = 1;
+  return SPI_OK;
+}
+
+/**
+  * @brief  Set the response sent by the slave from the next frame on. It is
+  *         sent again for each frame till another one is set.
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : data to send, dummy 0xFF if NULL. Kept till another
+  *         response is sent.
+  * @param  len : length in bytes of the response
+  * @retval None
+  */
+void spi_slave_set_response(spi_t *obj, const uint8_t *tx_buffer, uint16_t len)
+{
+  /* Not taken by the end of a frame while updated */
+  obj->slave_tx_pending = 0;
+  obj->slave_tx_next = (len != 0) ? tx_buffer : NULL;
+  obj->slave_tx_next_len = len;
+  obj->slave_tx_pending = 1;
+}
+
+/**
+  * @brief  End of a slave frame, to call on the ssel rising edge: the DMA
+  *         is set for the next frame before calling the callback.
+  * @param  obj : pointer to spi_t structure
+  * @retval None
+  */
+void spi_slave_frame_end(spi_t *obj)
+{
+  uint8_t *rx_buffer;
+  uint16_t len;
+
+  if ((obj == NULL) || !obj->slave_active) {
+    return;
+  }
+  rx_buffer = obj->slave_rx[obj->slave_rx_index];
+  /* Last frame read by the DMA */
+#if defined(SPI_SR_RXP)
+  while (LL_SPI_IsActiveFlag_RXP(obj->handle.Instance) &&
 #else
-    /* Wait for end of transfer */
-    while (LL_SPI_IsActiveFlag_BSY(_SPI));
+  while (LL_SPI_IsActiveFlag_RXNE(obj->handle.Instance) &&
 #endif
+         (__HAL_DMA_GET_COUNTER(&(obj->hdma_rx)) != 0));
+  len = obj->slave_rx_size - __HAL_DMA_GET_COUNTER(&(obj->hdma_rx));
+  spi_slave_disarm(obj);
+
+  if (obj->slave_tx_pending) {
+    obj->slave_tx_pending = 0;
+    obj->slave_tx = obj->slave_tx_next;
+    obj->slave_tx_len = obj->slave_tx_next_len;
+  }
+  obj->slave_rx_index ^= 1;
+  spi_slave_arm(obj);
+
+  if (len != 0) {
+    dma_invalidate_dcache(rx_buffer, obj->slave_rx_size);
+    if (obj->slave_callback != NULL) {
+      obj->slave_callback(obj->slave_arg, rx_buffer, len);
+    }
+  }
+}
+
+/**
+  * @brief  Stop the slave mode
+  * @param  obj : pointer to spi_t structure
+  * @retval None
+  */
+void spi_slave_stop(spi_t *obj)
+{
+  if ((obj == NULL) || !obj->slave_active) {
+    return;
+  }
+  obj->slave_active = 0;
+  spi_slave_disarm(obj);
+  LL_SPI_Disable(obj->handle.Instance);
+}
+#endif /* SPI_DMA_ENABLED */
+
+/**
+  * @brief  Send/receive bytes over SPI interface, by DMA above the threshold
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : tx data to send, dummy 0xFF if NULL
+  * @param  rx_buffer : rx data to receive if not NULL
+  * @param  len : length in byte of the data to send and receive
+  * @retval status of the transfer
+  */
+static spi_status_e spi_transfer_bytes(spi_t *obj, const uint8_t *tx_buffer,
+                                       uint8_t *rx_buffer, uint16_t len)
+{
+  spi_status_e ret = SPI_OK;
+
+  spi_set_frame_size(obj, 1);
+  spi_set_direction(obj, rx_buffer == NULL);
+
+  if (len == 0) {
+    ret = SPI_ERROR;
+#if defined(SPI_DMA_ENABLED)
+  } else if (spi_dma_usable(obj, rx_buffer, len, false)) {
+    ret = spi_transfer_dma(obj, tx_buffer, rx_buffer, len, 1);
+#endif
+  } else {
+    ret = spi_transfer_poll(obj, tx_buffer, rx_buffer, len, 1);
   }
   return ret;
 }
 
+/**
+  * @brief This function is implemented by user to send/receive data over
+  *         SPI interface
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : tx data to send before reception
+  * @param  rx_buffer : rx data to receive if not numm
+  * @param  len : length in byte of the data to send and receive
+  * @retval status of the send operation (0) in case of error
+  */
+spi_status_e spi_transfer(spi_t *obj, const uint8_t *tx_buffer, uint8_t *rx_buffer,
+                          uint16_t len)
+{
+  /* Wait for the end of an asynchronous transfer */
+  while (obj->async_busy);
+  return spi_transfer_bytes(obj, tx_buffer, rx_buffer, len);
+}
+
+/**
+  * @brief  Send/receive 16-bit or 32-bit frames over SPI interface.
+  *         Without 32-bit frames support, each word is sent as two 16-bit
+  *         frames, the most significant one first in MSB first mode.
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : tx frames to send, dummy 0xFFFF(FFFF) if NULL
+  * @param  rx_buffer : rx frames to receive if not NULL
+  * @param  len : number of frames to send and receive
+  * @param  size : frame size in bytes (2 or 4)
+  * @retval status of the transfer
+  */
+spi_status_e spi_transfer_frames(spi_t *obj, const void *tx_buffer, void *rx_buffer,
+                                 uint16_t len, uint8_t size)
+{
+  spi_status_e ret = SPI_OK;
+  uint32_t tickstart, data, first, second;
+  SPI_TypeDef *_SPI = obj->handle.Instance;
+  bool native = (size == 2) || spi_frame32_supported(obj);
+  bool msb_first = (obj->handle.Init.FirstBit == SPI_FIRSTBIT_MSB);
+
+  /* Wait for the end of an asynchronous transfer */
+  while (obj->async_busy);
+
+  if ((len == 0) || ((size != 2) && (size != 4)) ||
+      (!native && (len > (UINT16_MAX / 2)))) {
+    return SPI_ERROR;
+  }
+  spi_set_frame_size(obj, native ? size : 2);
+  /* Words sent as two frames are received to be rebuilt */
+  spi_set_direction(obj, native && (rx_buffer == NULL));
+  if (native) {
+#if defined(SPI_DMA_ENABLED)
+    if (spi_dma_usable(obj, rx_buffer, (uint32_t)len * size, false)) {
+      return spi_transfer_dma(obj, tx_buffer, rx_buffer, len, size);
+    }
+#endif
+    return spi_transfer_poll(obj, tx_buffer, rx_buffer, len, size);
+  }
+
+  /* Words sent as two 16-bit frames */
+  tickstart = HAL_GetTick();
+
+#if defined(SPI_CR2_TSIZE)
+  /* Start transfer */
+  LL_SPI_SetTransferSize(_SPI, len * 2);
+  LL_SPI_Enable(_SPI);
+  LL_SPI_StartMasterTransfer(_SPI);
+#endif
+
+  for (uint32_t i = 0; i < len; i++) {
+    data = tx_buffer ? ((const uint32_t *)tx_buffer)[i] : 0xFFFFFFFF;
+    first = spi_poll_frame16(_SPI, msb_first ? (data >> 16) : (data & 0xFFFF));
+    second = spi_poll_frame16(_SPI, msb_first ? (data & 0xFFFF) : (data >> 16));
+    if (rx_buffer) {
+      ((uint32_t *)rx_buffer)[i] = msb_first ? ((first << 16) | second) : ((second << 16) | first);
+    }
+    /* Timeout is checked by block of frames */
+    if (((i % SPI_TIMEOUT_CHECK_LOOPS) == 0) &&
+        (SPI_TRANSFER_TIMEOUT != HAL_MAX_DELAY) &&
+        (HAL_GetTick() - tickstart >= SPI_TRANSFER_TIMEOUT)) {
+      ret = SPI_TIMEOUT;
+      break;
+    }
+  }
+  spi_close_transfer(obj, false);
+  return ret;
+}
+
+/**
+  * @brief  Start an asynchronous transfer over SPI interface. With DMA, it is
+  *         ended from the DMA interrupt. Otherwise it is polled before
+  *         returning, or once the callback returns when started from it,
+  *         so that chained transfers do not nest.
+  *         From an interrupt (e.g. the callback of a DMA transfer), the
+  *         transfer is never polled: the DMA is used whatever its length,
+  *         if its channels allow it.
+  * @param  obj : pointer to spi_t structure
+  * @param  tx_buffer : tx data to send, dummy 0xFF if NULL
+  * @param  rx_buffer : rx data to receive if not NULL
+  * @param  len : length in byte of the data to send and receive
+  * @param  callback : function called at the end of the transfer, can be NULL
+  * @param  arg : argument given to the callback
+  * @note   Buffers must be kept until the end of the transfer.
+  * @retval SPI_OK if the transfer is started, SPI_ERROR if len is 0,
+  *         a transfer is on-going or it would be polled from an interrupt
+  */
+spi_status_e spi_transfer_async(spi_t *obj, const uint8_t *tx_buffer, uint8_t *rx_buffer,
+                                uint16_t len, void (*callback)(void *arg), void *arg)
+{
+  bool from_irq = (__get_IPSR() != 0U);
+
+  if ((obj == NULL) || (len == 0) || obj->async_busy) {
+    return SPI_ERROR;
+  }
+#if defined(SPI_DMA_ENABLED)
+  bool dma = spi_dma_usable(obj, rx_buffer, len, from_irq);
+#else
+  bool dma = false;
+#endif
+  if (from_irq && !dma && !obj->async_polling) {
+    return SPI_ERROR;
+  }
+  obj->async_callback = callback;
+  obj->async_arg = arg;
+  obj->async_status = SPI_OK;
+  obj->async_busy = 1;
+#if defined(SPI_DMA_ENABLED)
+  if (dma) {
+    spi_set_frame_size(obj, 1);
+    spi_set_direction(obj, rx_buffer == NULL);
+    spi_dma_start(obj, tx_buffer, rx_buffer, len, 1, true);
+    return SPI_OK;
+  }
+#endif
+  obj->async_tx = tx_buffer;
+  obj->async_rx = rx_buffer;
+  obj->async_len = len;
+  if (!obj->async_polling) {
+    obj->async_polling = 1;
+    /* Busy until the transfer is complete, the callback can start the next */
+    while (obj->async_len != 0) {
+      len = obj->async_len;
+      obj->async_len = 0;
+      spi_async_complete(obj, spi_transfer_bytes(obj, obj->async_tx, obj->async_rx, len));
+    }
+    obj->async_polling = 0;
+  }
+  return SPI_OK;
+}
+
+/**
+  * @brief  Wait for the end of an asynchronous transfer
+  * @param  obj : pointer to spi_t structure
+  * @retval status of the last asynchronous transfer
+  */
+spi_status_e spi_transfer_wait(spi_t *obj)
+{
+  while (obj->async_busy);
+  return (spi_status_e)obj->async_status;
+}
+
 #ifdef __cplusplus
 }
 #endif
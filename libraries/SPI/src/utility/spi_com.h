@@ -16,11 +16,17 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32_def.h"
 #include "PeripheralPins.h"
+#include "dma.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* DMA not supported by this series: transfers are polled */
+#if defined(SPI_DMA_ENABLED) && !defined(DMA_WRAPPER_ENABLED)
+#undef SPI_DMA_ENABLED
+#endif
+
 /* Exported types ------------------------------------------------------------*/
 
 struct spi_s {
@@ -34,11 +40,62 @@ struct spi_s {
   // Delay before disabling SPI.
   // See https://github.com/stm32duino/Arduino_Core_STM32/issues/1294
   uint32_t disable_delay;
+#endif
+  /* Asynchronous transfer */
+  volatile uint8_t async_busy;
+  volatile uint8_t async_status;
+  void (*async_callback)(void *arg);
+  void *async_arg;
+  /* Polled asynchronous transfer, started from the callback */
+  uint8_t async_polling;
+  const uint8_t *async_tx;
+  uint8_t *async_rx;
+  uint16_t async_len;
+#if defined(SPI_DMA_ENABLED)
+  /* DMA channels requested, NULL to poll all the transfers */
+  dma_channel_t *dma_tx;
+  uint32_t dma_tx_request;
+  DMA_HandleTypeDef hdma_tx;
+  dma_channel_t *dma_rx;
+  uint32_t dma_rx_request;
+  DMA_HandleTypeDef hdma_rx;
+  /* Transfers of at least dma_threshold bytes use the DMA, 0 to disable */
+  uint16_t dma_threshold;
+  /* DMA channels initialized (SPI_DMA_TX, SPI_DMA_RX) */
+  uint8_t dma_ready;
+  /* Current DMA transfer */
+  void *dma_rx_buffer;
+  uint16_t dma_len;
+  /* Slave mode: frames received in two buffers in turn */
+  volatile uint8_t slave_active;
+  uint8_t *slave_rx[2];
+  uint16_t slave_rx_size;
+  uint8_t slave_rx_index;
+  void (*slave_callback)(void *arg, uint8_t *rx_buffer, uint16_t len);
+  void *slave_arg;
+  /* Response sent for each frame, replaced by the next one if pending */
+  const uint8_t *slave_tx;
+  uint16_t slave_tx_len;
+  const uint8_t *slave_tx_next;
+  uint16_t slave_tx_next_len;
+  volatile uint8_t slave_tx_pending;
 #endif
 };
 
 typedef struct spi_s spi_t;
 
+/* SPI settings resolved into register values by spi_get_config() */
+typedef struct {
+#if defined(SPI_CR2_TSIZE)
+  uint32_t cfg1;
+  uint32_t cfg2;
+  uint32_t disable_delay;
+#else
+  uint32_t cr1;
+  uint32_t cr2;
+#endif
+} spi_config_t;
+
 
 ///@brief specifies the SPI speed bus in HZ.
 #define SPI_SPEED_CLOCK_DEFAULT     4000000
@@ -59,6 +116,17 @@ typedef struct spi_s spi_t;
 #error "SPI_TRANSFER_TIMEOUT cannot be less or equal to 0!"
 #endif
 
+#if defined(SPI_DMA_ENABLED)
+// Defines the default minimum size in bytes of the DMA transfers,
+// shorter ones are polled to keep a low latency
+#ifndef SPI_DMA_THRESHOLD
+#define SPI_DMA_THRESHOLD 32
+#endif
+
+#define SPI_DMA_TX  0x01
+#define SPI_DMA_RX  0x02
+#endif
+
 ///@brief specifies the SPI mode to use
 //Mode          Clock Polarity (CPOL)       Clock Phase (CPHA)
 //SPI_MODE0             0                         0
@@ -84,8 +152,24 @@ typedef enum {
 /* Exported functions ------------------------------------------------------- */
 void spi_init(spi_t *obj, uint32_t speed, SPIMode mode, uint8_t msb);
 void spi_deinit(spi_t *obj);
+void spi_get_config(spi_t *obj, uint32_t speed, SPIMode mode, uint8_t msb, spi_config_t *config);
+void spi_set_config(spi_t *obj, const spi_config_t *config);
 spi_status_e spi_transfer(spi_t *obj, const uint8_t *tx_buffer, uint8_t *rx_buffer, uint16_t len);
+spi_status_e spi_transfer_frames(spi_t *obj, const void *tx_buffer, void *rx_buffer,
+                                 uint16_t len, uint8_t size);
+spi_status_e spi_transfer_async(spi_t *obj, const uint8_t *tx_buffer, uint8_t *rx_buffer,
+                                uint16_t len, void (*callback)(void *arg), void *arg);
+spi_status_e spi_transfer_wait(spi_t *obj);
 uint32_t spi_getClkFreq(spi_t *obj);
+#if defined(SPI_DMA_ENABLED)
+void spi_attach_dma(spi_t *obj);
+spi_status_e spi_slave_init(spi_t *obj, SPIMode mode, uint8_t msb);
+spi_status_e spi_slave_start(spi_t *obj, uint8_t *rx_buffer0, uint8_t *rx_buffer1, uint16_t size,
+                             void (*callback)(void *arg, uint8_t *rx_buffer, uint16_t len), void *arg);
+void spi_slave_set_response(spi_t *obj, const uint8_t *tx_buffer, uint16_t len);
+void spi_slave_frame_end(spi_t *obj);
+void spi_slave_stop(spi_t *obj);
+#endif
 
 #ifdef __cplusplus
 }
@@ -35,11 +35,16 @@
 // Includes
 //
 #include "SoftwareSerial.h"
+#include "stm32yyxx_ll_exti.h"
 
 #define OVERSAMPLE 3 // in RX, Timer will generate interruption OVERSAMPLE time during a bit. Thus OVERSAMPLE ticks in a bit. (interrupt not synchronized with edge).
 
 // defined in bit-periods
 #define HALFDUPLEX_SWITCH_DELAY 5
+// Bit timings are computed per port, in 1/BIT_UNIT of bit
+#define BIT_UNIT 0x10000
+// Rounding margin of the bit step, negligible on a frame
+#define PHASE_MARGIN 16
 // It's best to define TIMER_SERIAL in variant.h. If not defined, we choose one here
 // The order is based on (lack of) features and compare channels, we choose the simplest available
 // because we only need an update interrupt
@@ -96,30 +101,75 @@
 // Static
 //
 HardwareTimer SoftwareSerial::timer(TIMER_SERIAL);
-SoftwareSerial *SoftwareSerial::active_listener = nullptr;
+SoftwareSerial *volatile SoftwareSerial::listeners = nullptr;
 SoftwareSerial *volatile SoftwareSerial::active_out = nullptr;
-SoftwareSerial *volatile SoftwareSerial::active_in = nullptr;
-int32_t SoftwareSerial::tx_tick_cnt = 0; // OVERSAMPLE ticks needed for a bit
-int32_t volatile SoftwareSerial::rx_tick_cnt = 0;  // OVERSAMPLE ticks needed for a bit
+uint32_t SoftwareSerial::tx_phase = 0; // part of the current bit elapsed (BIT_UNIT for a bit)
+uint32_t SoftwareSerial::tx_step = 0;  // part of a bit elapsed at each tick
 uint32_t SoftwareSerial::tx_buffer = 0;
 int32_t SoftwareSerial::tx_bit_cnt = 0;
-uint32_t SoftwareSerial::rx_buffer = 0;
-int32_t SoftwareSerial::rx_bit_cnt = -1; // rx_bit_cnt = -1 :  waiting for start bit
-uint32_t SoftwareSerial::cur_speed = 0;
+uint32_t SoftwareSerial::cur_speed = 0; // fastest speed, timer ticks OVERSAMPLE times per bit
+uint32_t SoftwareSerial::timer_clock = 0;
+uint32_t SoftwareSerial::tick_cycles = 0; // timer clock cycles per tick
+uint32_t SoftwareSerial::next_tick_cycles = 0; // tick_cycles once the new period is loaded
+volatile uint8_t SoftwareSerial::step_updates = 0; // update interrupts before using next_tick_cycles
+uint32_t SoftwareSerial::max_isr_count = 0;
 
 //
 // Private methods
 //
 
+// Part of a bit (BIT_UNIT for a bit) elapsed at each timer tick
+uint32_t SoftwareSerial::bitStep(uint32_t speed)
+{
+  if (timer_clock == 0) {
+    return 0;
+  }
+  return (uint32_t)((((uint64_t)speed * tick_cycles) << 16) / timer_clock);
+}
+
+// Fastest speed used by the listening ports
+uint32_t SoftwareSerial::requiredSpeed()
+{
+  uint32_t speed = 0;
+
+  for (SoftwareSerial *port = listeners; port != nullptr; port = port->_next_listener) {
+    if (port->_speed > speed) {
+      speed = port->_speed;
+    }
+  }
+  return speed;
+}
+
+// Ticks of tick_cycles timer clock cycles: set the bit steps of the ports
+void SoftwareSerial::setTickCycles(uint32_t cycles)
+{
+  tick_cycles = cycles;
+  // Bits already received keep their position
+  for (SoftwareSerial *port = listeners; port != nullptr; port = port->_next_listener) {
+    port->_rx_step = bitStep(port->_speed);
+  }
+  if (active_out) {
+    tx_step = bitStep(active_out->_speed);
+  }
+}
+
+// Timer ticks OVERSAMPLE times per bit of the given speed, slower ports
+// use several ticks per bit.
+// A running timer is not stopped: the new period is preloaded and loaded
+// by its next update, whose interrupt then applies the new bit steps.
 void SoftwareSerial::setSpeed(uint32_t speed)
 {
   if (speed != cur_speed) {
-    timer.pause();
+    TIM_TypeDef *tim = timer.getHandle()->Instance;
+    bool running = (cur_speed != 0) && (speed != 0);
+    if (!running) {
+      timer.pause();
+    }
     if (speed != 0) {
-      // Disable the timer
       uint32_t clock_rate, cmp_value;
       // Get timer clock
       clock_rate = timer.getTimerClkFreq();
+      timer_clock = clock_rate;
       int pre = 1;
       // Calculate prescale an compare value
       do {
@@ -129,37 +179,79 @@ void SoftwareSerial::setSpeed(uint32_t speed)
           pre *= 2;
         }
       } while (cmp_value >= UINT16_MAX);
-      timer.setPrescaleFactor(pre);
-      timer.setOverflow(cmp_value);
-      timer.setCount(0);
-      timer.attachInterrupt(&handleInterrupt);
-      timer.resume();
+      timer.setPreloadEnable(true);
+      noInterrupts();
+      if (running && LL_TIM_IsEnabledCounter(tim)) {
+        // A pending update interrupt ends a tick of the current period
+        step_updates = LL_TIM_IsActiveFlag_UPDATE(tim) ? 2 : 1;
+        next_tick_cycles = pre * cmp_value;
+        timer.setPrescaleFactor(pre);
+        timer.setOverflow(cmp_value);
+      } else {
+        // Loaded at once by a stopped timer
+        step_updates = 0;
+        timer.setPrescaleFactor(pre);
+        timer.setOverflow(cmp_value);
+        if (!running) {
+          timer.setCount(0);
+        }
+        setTickCycles(pre * cmp_value);
+      }
+      interrupts();
+      if (!running) {
+        timer.attachInterrupt(&handleInterrupt);
+        timer.resume();
+      }
     } else {
+      step_updates = 0;
       timer.detachInterrupt();
     }
     cur_speed = speed;
   }
 }
 
-// This function sets the current object as the "listening"
-// one and returns true if it replaces another
-bool SoftwareSerial::listen()
+// This function adds the current object to the "listening" ones,
+// if exclusive the other ports stop listening.
+// Returns true if it was not listening
+bool SoftwareSerial::listen(bool exclusive)
 {
-  if (active_listener != this) {
-    // wait for any transmit to complete as we may change speed
-    while (active_out);
-    if (active_listener != nullptr) {
-      active_listener->stopListening();
+  if (exclusive) {
+    SoftwareSerial *port = listeners;
+    while (port != nullptr) {
+      SoftwareSerial *next = port->_next_listener;
+      if (port != this) {
+        port->stopListening();
+      }
+      port = next;
+    }
+  }
+  if (!_listening) {
+    // A transmit in progress keeps its timing across a speed change, but
+    // the half-duplex pin can only be switched to input once it is done
+    if (_half_duplex) {
+      while (active_out);
     }
-    rx_tick_cnt = 1; // 1 : next interrupt will decrease rx_tick_cnt to 0 which means RX pin level will be considered.
-    rx_bit_cnt = -1; // rx_bit_cnt = -1 :  waiting for start bit
-    setSpeed(_speed);
-    active_listener = this;
+    _rx_enabled = false;
+    _rx_bit_cnt = -1; // _rx_bit_cnt = -1 :  waiting for start bit
+    noInterrupts();
+    _next_listener = listeners;
+    listeners = this;
+    _listening = true;
+    interrupts();
+    setSpeed(requiredSpeed());
+    _rx_step = bitStep(_speed);
     if (!_half_duplex) {
-      active_in = this;
-    } else if (!active_out) {
+      _rx_enabled = true;
+      if (_edge_detection) {
+        armStartBit();
+      }
+    } else {
       setRXTX(true);
     }
+    // Timer could be stopped if the other ports wait for an edge
+    if (needTick()) {
+      LL_TIM_EnableCounter(timer.getHandle()->Instance);
+    }
     return true;
   }
   return false;
@@ -168,16 +260,28 @@ bool SoftwareSerial::listen()
 // Stop listening. Returns true if we were actually listening.
 bool SoftwareSerial::stopListening()
 {
-  if (active_listener == this) {
+  if (_listening) {
     // wait for any output to complete
     while (active_out);
     if (_half_duplex) {
       setRXTX(false);
     }
-    active_listener = nullptr;
-    active_in = nullptr;
-    // turn off ints
-    setSpeed(0);
+#if !defined(HAL_EXTI_MODULE_DISABLED)
+    if (_edge_detection && !_half_duplex) {
+      detachInterrupt(_receivePin);
+    }
+#endif
+    noInterrupts();
+    SoftwareSerial *volatile *link = &listeners;
+    while (*link != this) {
+      link = &((*link)->_next_listener);
+    }
+    *link = _next_listener;
+    _listening = false;
+    _rx_enabled = false;
+    interrupts();
+    // turn off ints if no port is listening
+    setSpeed(requiredSpeed());
     return true;
   }
   return false;
@@ -202,16 +306,15 @@ inline void SoftwareSerial::setRXTX(bool input)
 {
   if (_half_duplex) {
     if (input) {
-      if (active_in != this) {
+      if (!_rx_enabled) {
         setRX();
-        rx_bit_cnt = -1; // rx_bit_cnt = -1 :  waiting for start bit
-        rx_tick_cnt = 2; // 2 : next interrupt will be discarded. 2 interrupts required to consider RX pin level
-        active_in = this;
+        _rx_bit_cnt = -2; // _rx_bit_cnt = -2 : next interrupt will be discarded, then waiting for start bit
+        _rx_enabled = true;
       }
     } else {
-      if (active_in == this) {
+      if (_rx_enabled) {
         setTX();
-        active_in = nullptr;
+        _rx_enabled = false;
       }
     }
   }
@@ -219,7 +322,9 @@ inline void SoftwareSerial::setRXTX(bool input)
 
 inline void SoftwareSerial::send()
 {
-  if (--tx_tick_cnt <= 0) { // if tx_tick_cnt > 0 interrupt is discarded. Only when tx_tick_cnt reach 0 we set TX pin.
+  tx_phase += tx_step;
+  if (tx_phase >= BIT_UNIT) { // if tx_phase < BIT_UNIT interrupt is discarded. Only when a bit is elapsed we set TX pin.
+    tx_phase -= BIT_UNIT;
     if (tx_bit_cnt++ < 10) { // tx_bit_cnt < 10 transmission is not fiisehed (10 = 1 start +8 bits + 1 stop)
       // send data (including start and stop bits)
       if (tx_buffer & 1) {
@@ -228,16 +333,14 @@ inline void SoftwareSerial::send()
         LL_GPIO_ResetOutputPin(_transmitPinPort, _transmitPinNumber);
       }
       tx_buffer >>= 1;
-      tx_tick_cnt = OVERSAMPLE; // Wait OVERSAMPLE tick to send next bit
     } else { // Transmission finished
-      tx_tick_cnt = 1;
       if (_output_pending) {
         active_out = nullptr;
 
         // When in half-duplex mode, wait for HALFDUPLEX_SWITCH_DELAY bit-periods after the byte has
         // been transmitted before allowing the switch to RX mode
-      } else if (tx_bit_cnt > 10 + OVERSAMPLE * HALFDUPLEX_SWITCH_DELAY) {
-        if (_half_duplex && active_listener == this) {
+      } else if (tx_bit_cnt > 10 + HALFDUPLEX_SWITCH_DELAY) {
+        if (_half_duplex && _listening) {
           setRXTX(true);
         }
         active_out = nullptr;
@@ -251,44 +354,73 @@ inline void SoftwareSerial::send()
 //
 inline void SoftwareSerial::recv()
 {
-  if (--rx_tick_cnt <= 0) { // if rx_tick_cnt > 0 interrupt is discarded. Only when rx_tick_cnt reach 0 RX pin is considered
+  if (_rx_bit_cnt < 0) {
+    if (_rx_bit_cnt == -2) {
+      // Pin has just been switched to input, its level is not considered
+      _rx_bit_cnt = -1;
+      return;
+    }
     bool inbit = LL_GPIO_IsInputPinSet(_receivePinPort, _receivePinNumber) ^ _inverse_logic;
-    if (rx_bit_cnt == -1) {  // rx_bit_cnt = -1 :  waiting for start bit
-      if (!inbit) {
-        // got start bit
-        rx_bit_cnt = 0; // rx_bit_cnt == 0 : start bit received
-        rx_tick_cnt = OVERSAMPLE + 1; // Wait 1 bit (OVERSAMPLE ticks) + 1 tick in order to sample RX pin in the middle of the edge (and not too close to the edge)
-        rx_buffer = 0;
-      } else {
-        rx_tick_cnt = 1; // Waiting for start bit, but we don't get right level. Wait for next Interrupt to ckech RX pin level
-      }
-    } else if (rx_bit_cnt >= 8) { // rx_bit_cnt >= 8 : waiting for stop bit
+    if (!inbit) {
+      // got start bit, during the last tick (half a tick ago on average).
+      // Wait 1.5 bit from the edge in order to sample RX pin in the middle of the bits
+      _rx_phase = -(int32_t)(BIT_UNIT / 2) + (int32_t)(_rx_step / 2) + PHASE_MARGIN;
+      _rx_buffer = 0;
+      _rx_bit_cnt = 0; // _rx_bit_cnt == 0 : start bit received
+    }
+    return;
+  }
+  _rx_phase += _rx_step;
+  if (_rx_phase >= (int32_t)BIT_UNIT) { // if _rx_phase < BIT_UNIT interrupt is discarded. Only when a bit is elapsed RX pin is considered
+    _rx_phase -= BIT_UNIT;
+    bool inbit = LL_GPIO_IsInputPinSet(_receivePinPort, _receivePinNumber) ^ _inverse_logic;
+    if (_rx_bit_cnt >= 8) { // _rx_bit_cnt >= 8 : waiting for stop bit
       if (inbit) {
         // stop bit read complete add to buffer
         uint8_t next = (_receive_buffer_tail + 1) % _SS_MAX_RX_BUFF;
         if (next != _receive_buffer_head) {
           // save new data in buffer: tail points to where byte goes
-          _receive_buffer[_receive_buffer_tail] = rx_buffer; // save new byte
+          _receive_buffer[_receive_buffer_tail] = _rx_buffer; // save new byte
           _receive_buffer_tail = next;
-        } else { // rx_bit_cnt = x  with x = [0..7] correspond to new bit x received
+        } else { // _rx_bit_cnt = x  with x = [0..7] correspond to new bit x received
           _buffer_overflow = true;
         }
       }
       // Full trame received. Restart waiting for start bit at next interrupt
-      rx_tick_cnt = 1;
-      rx_bit_cnt = -1;
+      _rx_bit_cnt = -1;
+#if !defined(HAL_EXTI_MODULE_DISABLED)
+      if (_edge_detection && !_half_duplex) {
+        // Data bits edges are ignored, wait for the next start bit
+        __HAL_GPIO_EXTI_CLEAR_IT(_receiveExtiLine);
+        LL_EXTI_EnableIT_0_31(_receiveExtiLine);
+      }
+#endif
     } else {
       // data bits
-      rx_buffer >>= 1;
+      _rx_buffer >>= 1;
       if (inbit) {
-        rx_buffer |= 0x80;
+        _rx_buffer |= 0x80;
       }
-      rx_bit_cnt++; // Prepare for next bit
-      rx_tick_cnt = OVERSAMPLE; // Wait OVERSAMPLE ticks before sampling next bit
+      _rx_bit_cnt++; // Prepare for next bit
     }
   }
 }
 
+// Check if the timer ticks are used by a port
+inline bool SoftwareSerial::needTick()
+{
+  if (active_out) {
+    return true;
+  }
+  for (SoftwareSerial *port = listeners; port != nullptr; port = port->_next_listener) {
+    // With edge detection, the start bit is detected by startBit()
+    if (port->_rx_enabled && (!port->_edge_detection || port->_half_duplex || (port->_rx_bit_cnt != -1))) {
+      return true;
+    }
+  }
+  return false;
+}
+
 //
 // Interrupt handling
 //
@@ -296,12 +428,75 @@ inline void SoftwareSerial::recv()
 /* static */
 inline void SoftwareSerial::handleInterrupt()
 {
-  if (active_in) {
-    active_in->recv();
+  TIM_TypeDef *tim = timer.getHandle()->Instance;
+  uint32_t count;
+
+  // One tick for all the listening ports, whatever their speed
+  for (SoftwareSerial *port = listeners; port != nullptr; port = port->_next_listener) {
+    if (port->_rx_enabled && (!port->_edge_detection || port->_half_duplex || (port->_rx_bit_cnt != -1))) {
+      port->recv();
+    }
   }
   if (active_out) {
     active_out->send();
   }
+  // The tick which just ended had the previous period, the next ones have
+  // the new one
+  if ((step_updates != 0) && (--step_updates == 0)) {
+    setTickCycles(next_tick_cycles);
+  }
+  // Nothing to sample till the next start bit
+  if (!active_out) {
+    // startBit() could preempt this handler
+    noInterrupts();
+    if (!needTick()) {
+      LL_TIM_DisableCounter(tim);
+    }
+    interrupts();
+  }
+
+  // Time elapsed since the tick (including the interrupt latency)
+  count = LL_TIM_GetCounter(tim);
+  if (LL_TIM_IsActiveFlag_UPDATE(tim)) {
+    count += LL_TIM_GetAutoReload(tim) + 1;
+  }
+  if (count > max_isr_count) {
+    max_isr_count = count;
+  }
+}
+
+#if !defined(HAL_EXTI_MODULE_DISABLED)
+void SoftwareSerial::startBit()
+{
+  TIM_TypeDef *tim = timer.getHandle()->Instance;
+
+  if (!_rx_enabled || (_rx_bit_cnt != -1)) {
+    return;
+  }
+  // Mask the edges of the data bits till the stop bit
+  LL_EXTI_DisableIT_0_31(_receiveExtiLine);
+  // Next tick is half a tick after the edge, on average if the timer is
+  // running for another port, else the timer is synchronized on the edge
+  _rx_phase = -(int32_t)(BIT_UNIT / 2) - (int32_t)(_rx_step / 2) + PHASE_MARGIN;
+  _rx_buffer = 0;
+  _rx_bit_cnt = 0; // _rx_bit_cnt == 0 : start bit received
+  if (!LL_TIM_IsEnabledCounter(tim)) {
+    LL_TIM_SetCounter(tim, LL_TIM_GetAutoReload(tim) / 2);
+    LL_TIM_EnableCounter(tim);
+  }
+}
+#endif
+
+void SoftwareSerial::armStartBit()
+{
+#if !defined(HAL_EXTI_MODULE_DISABLED)
+  attachInterrupt(_receivePin, [this]() {
+    startBit();
+  }, _inverse_logic ? RISING : FALLING);
+#else
+  // No EXTI: start bit is polled by the timer
+  _edge_detection = false;
+#endif
 }
 //
 // Constructor
@@ -313,13 +508,22 @@ SoftwareSerial::SoftwareSerial(uint16_t receivePin, uint16_t transmitPin, bool i
   _receivePinNumber(STM_LL_GPIO_PIN(digitalPinToPinName(receivePin))),
   _transmitPinPort(digitalPinToPort(transmitPin)),
   _transmitPinNumber(STM_LL_GPIO_PIN(digitalPinToPinName(transmitPin))),
+  _receiveExtiLine(STM_GPIO_PIN(digitalPinToPinName(receivePin))),
   _speed(0),
   _buffer_overflow(false),
   _inverse_logic(inverse_logic),
   _half_duplex(receivePin == transmitPin),
   _output_pending(0),
+  _edge_detection(0),
   _receive_buffer_tail(0),
-  _receive_buffer_head(0)
+  _receive_buffer_head(0),
+  _next_listener(nullptr),
+  _listening(false),
+  _rx_enabled(false),
+  _rx_phase(0),
+  _rx_step(0),
+  _rx_bit_cnt(-1),
+  _rx_buffer(0)
 {
   /* Enable GPIO clock for tx and rx pin*/
   if (set_GPIO_Port_Clock(STM_PORT(digitalPinToPinName(transmitPin))) == 0) {
@@ -393,14 +597,17 @@ size_t SoftwareSerial::write(uint8_t b)
     tx_buffer = ~tx_buffer;
   }
   tx_bit_cnt = 0;
-  tx_tick_cnt = OVERSAMPLE;
-  setSpeed(_speed);
+  setSpeed(max(requiredSpeed(), _speed));
+  tx_step = bitStep(_speed);
+  tx_phase = PHASE_MARGIN;
   if (_half_duplex) {
     setRXTX(false);
   }
   _output_pending = 0;
   // make us active
   active_out = this;
+  // Timer may be stopped between two receptions with edge detection
+  LL_TIM_EnableCounter(timer.getHandle()->Instance);
   return 1;
 }
 
@@ -426,3 +633,25 @@ void SoftwareSerial::setInterruptPriority(uint32_t preemptPriority, uint32_t sub
 {
   timer.setInterruptPriority(preemptPriority, subPriority);
 }
+
+uint32_t SoftwareSerial::getInterruptPeriod()
+{
+  if (timer_clock == 0) {
+    return 0;
+  }
+  return (uint32_t)((uint64_t)tick_cycles * 1000000000ULL / timer_clock);
+}
+
+uint32_t SoftwareSerial::getMaxInterruptTime()
+{
+  if (timer_clock == 0) {
+    return 0;
+  }
+  uint32_t prescaler = LL_TIM_GetPrescaler(timer.getHandle()->Instance) + 1;
+  return (uint32_t)((uint64_t)max_isr_count * prescaler * 1000000000ULL / timer_clock);
+}
+
+void SoftwareSerial::resetMaxInterruptTime()
+{
+  max_isr_count = 0;
+}
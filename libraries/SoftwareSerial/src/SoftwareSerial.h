@@ -50,12 +50,14 @@ class SoftwareSerial : public Stream {
     uint32_t _receivePinNumber;
     GPIO_TypeDef *_transmitPinPort;
     uint32_t _transmitPinNumber;
+    uint16_t _receiveExtiLine;
     uint32_t _speed;
 
     uint16_t _buffer_overflow: 1;
     uint16_t _inverse_logic: 1;
     uint16_t _half_duplex: 1;
     uint16_t _output_pending: 1;
+    uint16_t _edge_detection: 1;
 
     unsigned char _receive_buffer[_SS_MAX_RX_BUFF];
     volatile uint8_t _receive_buffer_tail;
@@ -63,28 +65,45 @@ class SoftwareSerial : public Stream {
 
     uint32_t delta_start = 0;
 
+    // receive state, all the listening ports are sampled on the same tick
+    SoftwareSerial *volatile _next_listener;
+    volatile bool _listening;
+    volatile bool _rx_enabled;
+    int32_t _rx_phase;
+    uint32_t _rx_step;
+    volatile int32_t _rx_bit_cnt;
+    uint8_t _rx_buffer;
+
     // static data
     static bool initialised;
     static HardwareTimer timer;
-    static SoftwareSerial *active_listener;
+    static SoftwareSerial *volatile listeners;
     static SoftwareSerial *volatile active_out;
-    static SoftwareSerial *volatile active_in;
-    static int32_t tx_tick_cnt;
-    static volatile int32_t rx_tick_cnt;
+    static uint32_t tx_phase;
+    static uint32_t tx_step;
     static uint32_t tx_buffer;
     static int32_t tx_bit_cnt;
-    static uint32_t rx_buffer;
-    static int32_t rx_bit_cnt;
     static uint32_t cur_speed;
+    static uint32_t timer_clock;
+    static uint32_t tick_cycles;
+    static uint32_t next_tick_cycles;
+    static volatile uint8_t step_updates;
+    static uint32_t max_isr_count;
 
     // private methods
     void send();
     void recv();
     void setTX();
     void setRX();
-    void setSpeed(uint32_t speed);
+    static void setTickCycles(uint32_t cycles);
+    static void setSpeed(uint32_t speed);
+    static uint32_t requiredSpeed();
+    static uint32_t bitStep(uint32_t speed);
     void setRXTX(bool input);
+    static bool needTick();
     static void handleInterrupt();
+    void startBit();
+    void armStartBit();
 
   public:
     // public methods
@@ -92,11 +111,13 @@ class SoftwareSerial : public Stream {
     SoftwareSerial(uint16_t receivePin, uint16_t transmitPin, bool inverse_logic = false);
     virtual ~SoftwareSerial();
     void begin(long speed);
-    bool listen();
+    // Several ports can listen at the same time (at different speeds)
+    // if they are not exclusive, the timer ticks at the fastest speed
+    bool listen(bool exclusive = true);
     void end();
     bool isListening()
     {
-      return active_listener == this;
+      return _listening;
     }
     bool stopListening();
     bool overflow()
@@ -119,6 +140,21 @@ class SoftwareSerial : public Stream {
     }
 
     static void setInterruptPriority(uint32_t preemptPriority, uint32_t subPriority);
+    // Period of the timer interrupt and worst time spent in it since the
+    // last reset (including its latency), in nanoseconds. The interrupt
+    // time of a set of listening ports must stay below the period.
+    static uint32_t getInterruptPeriod();
+    static uint32_t getMaxInterruptTime();
+    static void resetMaxInterruptTime();
+
+    // Detect the start bit with an EXTI interrupt on the RX pin: the timer
+    // runs only during the reception of a byte (or a transmission) instead
+    // of permanently while listening. Full-duplex only.
+    // This needs to be done before the call to begin()
+    void enableEdgeDetection(bool enable = true)
+    {
+      _edge_detection = enable;
+    }
 
     using Print::write;
 };
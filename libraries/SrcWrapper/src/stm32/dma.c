@@ -0,0 +1,462 @@
+/*
+ *******************************************************************************
+ * Copyright (c) 2024, STMicroelectronics
+ * All rights reserved.
+ *
+ * This software component is licensed by ST under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ *******************************************************************************
+ */
+#include "dma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(DMA_WRAPPER_ENABLED)
+
+#if defined(DMA1_Stream0_BASE)
+#define DMA1_FIRST_BASE     DMA1_Stream0_BASE
+#define DMA2_FIRST_BASE     DMA2_Stream0_BASE
+#define DMA_CHANNEL_STRIDE  (DMA1_Stream1_BASE - DMA1_Stream0_BASE)
+#else
+#define DMA1_FIRST_BASE     DMA1_Channel1_BASE
+#define DMA2_FIRST_BASE     DMA2_Channel1_BASE
+#define DMA_CHANNEL_STRIDE  (DMA1_Channel2_BASE - DMA1_Channel1_BASE)
+#endif
+
+/* DMA handles registered by the drivers, indexed by channel (or stream) */
+static DMA_HandleTypeDef *dma_handlers[DMA_NUM] = {NULL};
+
+/**
+  * @brief  Get the index of a DMA channel (or stream)
+  * @param  instance : DMA channel (or stream)
+  * @retval index in dma_handlers[], DMA_NUM if invalid
+  */
+static uint32_t dma_get_index(dma_channel_t *instance)
+{
+  uint32_t base = (uint32_t)instance;
+  uint32_t index = 0;
+
+  if (dma_get_irqn(instance) == NonMaskableInt_IRQn) {
+    return DMA_NUM;
+  }
+#if defined(DMA2_BASE)
+  if (base >= DMA2_FIRST_BASE) {
+    base -= DMA2_FIRST_BASE;
+    index = DMA_CHANNEL_PER_CONTROLLER;
+  } else
+#endif
+  {
+    base -= DMA1_FIRST_BASE;
+  }
+  return index + (base / DMA_CHANNEL_STRIDE);
+}
+
+/**
+  * @brief  Get the IRQ number of a DMA channel (or stream)
+  * @param  instance : DMA channel (or stream)
+  * @retval IRQ number, NonMaskableInt_IRQn if the channel does not exist
+  */
+IRQn_Type dma_get_irqn(dma_channel_t *instance)
+{
+  IRQn_Type IRQn = NonMaskableInt_IRQn;
+
+  switch ((uint32_t)instance) {
+#if defined(DMA1_Stream0_BASE)
+    case (uint32_t)DMA1_Stream0_BASE:
+      IRQn = DMA1_Stream0_IRQn;
+      break;
+    case (uint32_t)DMA1_Stream1_BASE:
+      IRQn = DMA1_Stream1_IRQn;
+      break;
+    case (uint32_t)DMA1_Stream2_BASE:
+      IRQn = DMA1_Stream2_IRQn;
+      break;
+    case (uint32_t)DMA1_Stream3_BASE:
+      IRQn = DMA1_Stream3_IRQn;
+      break;
+    case (uint32_t)DMA1_Stream4_BASE:
+      IRQn = DMA1_Stream4_IRQn;
+      break;
+    case (uint32_t)DMA1_Stream5_BASE:
+      IRQn = DMA1_Stream5_IRQn;
+      break;
+    case (uint32_t)DMA1_Stream6_BASE:
+      IRQn = DMA1_Stream6_IRQn;
+      break;
+    case (uint32_t)DMA1_Stream7_BASE:
+      IRQn = DMA1_Stream7_IRQn;
+      break;
+#endif
+#if defined(DMA2_Stream0_BASE)
+    case (uint32_t)DMA2_Stream0_BASE:
+      IRQn = DMA2_Stream0_IRQn;
+      break;
+    case (uint32_t)DMA2_Stream1_BASE:
+      IRQn = DMA2_Stream1_IRQn;
+      break;
+    case (uint32_t)DMA2_Stream2_BASE:
+      IRQn = DMA2_Stream2_IRQn;
+      break;
+    case (uint32_t)DMA2_Stream3_BASE:
+      IRQn = DMA2_Stream3_IRQn;
+      break;
+    case (uint32_t)DMA2_Stream4_BASE:
+      IRQn = DMA2_Stream4_IRQn;
+      break;
+    case (uint32_t)DMA2_Stream5_BASE:
+      IRQn = DMA2_Stream5_IRQn;
+      break;
+    case (uint32_t)DMA2_Stream6_BASE:
+      IRQn = DMA2_Stream6_IRQn;
+      break;
+    case (uint32_t)DMA2_Stream7_BASE:
+      IRQn = DMA2_Stream7_IRQn;
+      break;
+#endif
+#if defined(DMA1_Channel1_BASE)
+    case (uint32_t)DMA1_Channel1_BASE:
+      IRQn = DMA1_Channel1_IRQn;
+      break;
+#endif
+#if defined(DMA1_Channel2_BASE)
+    case (uint32_t)DMA1_Channel2_BASE:
+      IRQn = DMA1_Channel2_IRQn;
+      break;
+#endif
+#if defined(DMA1_Channel3_BASE)
+    case (uint32_t)DMA1_Channel3_BASE:
+      IRQn = DMA1_Channel3_IRQn;
+      break;
+#endif
+#if defined(DMA1_Channel4_BASE)
+    case (uint32_t)DMA1_Channel4_BASE:
+      IRQn = DMA1_Channel4_IRQn;
+      break;
+#endif
+#if defined(DMA1_Channel5_BASE)
+    case (uint32_t)DMA1_Channel5_BASE:
+      IRQn = DMA1_Channel5_IRQn;
+      break;
+#endif
+#if defined(DMA1_Channel6_BASE)
+    case (uint32_t)DMA1_Channel6_BASE:
+      IRQn = DMA1_Channel6_IRQn;
+      break;
+#endif
+#if defined(DMA1_Channel7_BASE)
+    case (uint32_t)DMA1_Channel7_BASE:
+      IRQn = DMA1_Channel7_IRQn;
+      break;
+#endif
+#if defined(DMA1_Channel8_BASE)
+    case (uint32_t)DMA1_Channel8_BASE:
+      IRQn = DMA1_Channel8_IRQn;
+      break;
+#endif
+#if defined(DMA2_Channel1_BASE)
+    case (uint32_t)DMA2_Channel1_BASE:
+      IRQn = DMA2_Channel1_IRQn;
+      break;
+#endif
+#if defined(DMA2_Channel2_BASE)
+    case (uint32_t)DMA2_Channel2_BASE:
+      IRQn = DMA2_Channel2_IRQn;
+      break;
+#endif
+#if defined(DMA2_Channel3_BASE)
+    case (uint32_t)DMA2_Channel3_BASE:
+      IRQn = DMA2_Channel3_IRQn;
+      break;
+#endif
+#if defined(DMA2_Channel4_BASE)
+    case (uint32_t)DMA2_Channel4_BASE:
+      IRQn = DMA2_Channel4_IRQn;
+      break;
+#endif
+#if defined(DMA2_Channel5_BASE)
+    case (uint32_t)DMA2_Channel5_BASE:
+      IRQn = DMA2_Channel5_IRQn;
+      break;
+#endif
+#if defined(DMA2_Channel6_BASE)
+    case (uint32_t)DMA2_Channel6_BASE:
+      IRQn = DMA2_Channel6_IRQn;
+      break;
+#endif
+#if defined(DMA2_Channel7_BASE)
+    case (uint32_t)DMA2_Channel7_BASE:
+      IRQn = DMA2_Channel7_IRQn;
+      break;
+#endif
+#if defined(DMA2_Channel8_BASE)
+    case (uint32_t)DMA2_Channel8_BASE:
+      IRQn = DMA2_Channel8_IRQn;
+      break;
+#endif
+    default:
+      break;
+  }
+  return IRQn;
+}
+
+/**
+  * @brief  Initialize a DMA channel (or stream) and its interrupt
+  * @note   Peripheral address is not incremented, memory address is.
+  * @param  hdma : DMA handle to initialize
+  * @param  instance : DMA channel (or stream) to use
+  * @param  request : DMA request (DMA_REQUEST_xxx), or channel selection
+  *         (DMA_CHANNEL_x) for stream based DMA. Remap value on STM32F0xx
+  *         (DMAx_CHANNELy_zzz), ignored on series with fixed mapping.
+  * @param  direction : DMA_PERIPH_TO_MEMORY or DMA_MEMORY_TO_PERIPH
+  * @param  mode : DMA_NORMAL or DMA_CIRCULAR
+  * @param  datasize : data size in bytes (1, 2 or 4)
+  * @retval true if the DMA is ready, false otherwise
+  */
+bool dma_init(DMA_HandleTypeDef *hdma, dma_channel_t *instance, uint32_t request,
+              uint32_t direction, uint32_t mode, uint32_t datasize)
+{
+  uint32_t index = dma_get_index(instance);
+  IRQn_Type irqn;
+
+  if ((hdma == NULL) || (index >= DMA_NUM)) {
+    return false;
+  }
+  /* Channel already used by another driver */
+  if ((dma_handlers[index] != NULL) && (dma_handlers[index] != hdma)) {
+    return false;
+  }
+
+  /* Enable DMA clock */
+#if defined(DMA2_BASE)
+  if (index >= DMA_CHANNEL_PER_CONTROLLER) {
+    __HAL_RCC_DMA2_CLK_ENABLE();
+  } else
+#endif
+  {
+    __HAL_RCC_DMA1_CLK_ENABLE();
+  }
+#if defined(__HAL_RCC_DMAMUX1_CLK_ENABLE)
+  __HAL_RCC_DMAMUX1_CLK_ENABLE();
+#endif
+
+  hdma->Instance = instance;
+#if defined(DMA_SxCR_CHSEL)
+  hdma->Init.Channel = request;
+#elif !defined(STM32F0xx) && !defined(STM32F1xx) && !defined(STM32F3xx) && !defined(STM32L1xx)
+  hdma->Init.Request = request;
+#elif defined(__HAL_DMA1_REMAP)
+  if (request != 0) {
+#if defined(__HAL_DMA2_REMAP)
+    if (index >= DMA_CHANNEL_PER_CONTROLLER) {
+      __HAL_DMA2_REMAP(request);
+    } else
+#endif
+    {
+      __HAL_DMA1_REMAP(request);
+    }
+  }
+#else
+  UNUSED(request);
+#endif
+  hdma->Init.Direction = direction;
+  hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma->Init.MemInc = DMA_MINC_ENABLE;
+  switch (datasize) {
+    case 4:
+      hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+      hdma->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+      break;
+    case 2:
+      hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+      hdma->Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+      break;
+    default:
+      hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+      hdma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+      break;
+  }
+  hdma->Init.Mode = mode;
+  hdma->Init.Priority = DMA_PRIORITY_HIGH;
+#if defined(DMA_FIFOMODE_DISABLE)
+  hdma->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  hdma->Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+  hdma->Init.MemBurst = DMA_MBURST_SINGLE;
+  hdma->Init.PeriphBurst = DMA_PBURST_SINGLE;
+#endif
+
+  if (HAL_DMA_Init(hdma) != HAL_OK) {
+    return false;
+  }
+  dma_handlers[index] = hdma;
+
+  irqn = dma_get_irqn(instance);
+  HAL_NVIC_SetPriority(irqn, DMA_IRQ_PRIO, DMA_IRQ_SUBPRIO);
+  HAL_NVIC_EnableIRQ(irqn);
+  return true;
+}
+
+/**
+  * @brief  Deinitialize a DMA channel (or stream)
+  * @note   The interrupt is disabled only if no other channel shares it.
+  * @param  hdma : DMA handle to deinitialize
+  * @retval None
+  */
+void dma_deinit(DMA_HandleTypeDef *hdma)
+{
+  uint32_t index;
+  IRQn_Type irqn;
+  bool shared = false;
+
+  if ((hdma == NULL) || (hdma->Instance == NULL)) {
+    return;
+  }
+  index = dma_get_index((dma_channel_t *)hdma->Instance);
+  if ((index >= DMA_NUM) || (dma_handlers[index] != hdma)) {
+    return;
+  }
+
+  irqn = dma_get_irqn((dma_channel_t *)hdma->Instance);
+  dma_handlers[index] = NULL;
+  for (uint32_t i = 0; i < DMA_NUM; i++) {
+    if ((dma_handlers[i] != NULL) &&
+        (dma_get_irqn((dma_channel_t *)dma_handlers[i]->Instance) == irqn)) {
+      shared = true;
+      break;
+    }
+  }
+  if (!shared) {
+    HAL_NVIC_DisableIRQ(irqn);
+  }
+  HAL_DMA_DeInit(hdma);
+}
+
+#if defined(DMA_IRQ_HANDLER_ENABLED)
+/**
+  * @brief  Call HAL DMA IRQ handler of registered channels
+  * @param  first : index of the first channel sharing the IRQ
+  * @param  last : index of the last channel sharing the IRQ
+  * @retval None
+  */
+static void dma_irq_handler(uint32_t first, uint32_t last)
+{
+  for (uint32_t i = first; i <= last; i++) {
+    if (dma_handlers[i] != NULL) {
+      HAL_DMA_IRQHandler(dma_handlers[i]);
+    }
+  }
+}
+
+#define DMA_IRQHANDLER(name, first, last)   \
+  void name##_IRQHandler(void)              \
+  {                                         \
+    dma_irq_handler(first, last);           \
+  }
+
+#if defined(DMA1_Stream0_BASE)
+/* Stream based DMA: one IRQ per stream */
+DMA_IRQHANDLER(DMA1_Stream0, 0, 0)
+DMA_IRQHANDLER(DMA1_Stream1, 1, 1)
+DMA_IRQHANDLER(DMA1_Stream2, 2, 2)
+DMA_IRQHANDLER(DMA1_Stream3, 3, 3)
+DMA_IRQHANDLER(DMA1_Stream4, 4, 4)
+DMA_IRQHANDLER(DMA1_Stream5, 5, 5)
+DMA_IRQHANDLER(DMA1_Stream6, 6, 6)
+DMA_IRQHANDLER(DMA1_Stream7, 7, 7)
+#if defined(DMA2_Stream0_BASE)
+DMA_IRQHANDLER(DMA2_Stream0, 8, 8)
+DMA_IRQHANDLER(DMA2_Stream1, 9, 9)
+DMA_IRQHANDLER(DMA2_Stream2, 10, 10)
+DMA_IRQHANDLER(DMA2_Stream3, 11, 11)
+DMA_IRQHANDLER(DMA2_Stream4, 12, 12)
+DMA_IRQHANDLER(DMA2_Stream5, 13, 13)
+DMA_IRQHANDLER(DMA2_Stream6, 14, 14)
+DMA_IRQHANDLER(DMA2_Stream7, 15, 15)
+#endif
+#elif defined(STM32C0xx) || defined(STM32F0xx) || defined(STM32G0xx) || defined(STM32L0xx)
+/* Channels 2 and 3, then channels 4 to 7 share the same IRQ */
+DMA_IRQHANDLER(DMA1_Channel1, 0, 0)
+#if defined(STM32F091xC) || defined(STM32F098xx)
+void DMA1_Channel2_IRQHandler(void)
+{
+  dma_irq_handler(1, 2);
+  dma_irq_handler(8, 9);
+}
+
+void DMA1_Channel4_IRQHandler(void)
+{
+  dma_irq_handler(3, 6);
+  dma_irq_handler(10, 12);
+}
+#else
+DMA_IRQHANDLER(DMA1_Channel2, 1, 2)
+#if defined(DMA1_Channel4_BASE)
+void DMA1_Channel4_IRQHandler(void)
+{
+  dma_irq_handler(3, 6);
+#if defined(DMA2_BASE)
+  dma_irq_handler(8, 12);
+#endif
+}
+#endif
+#endif /* STM32F091xC || STM32F098xx */
+#else
+/* Channel based DMA: one IRQ per channel */
+DMA_IRQHANDLER(DMA1_Channel1, 0, 0)
+DMA_IRQHANDLER(DMA1_Channel2, 1, 1)
+DMA_IRQHANDLER(DMA1_Channel3, 2, 2)
+#if defined(DMA1_Channel4_BASE)
+DMA_IRQHANDLER(DMA1_Channel4, 3, 3)
+#endif
+#if defined(DMA1_Channel5_BASE)
+DMA_IRQHANDLER(DMA1_Channel5, 4, 4)
+#endif
+#if defined(DMA1_Channel6_BASE)
+DMA_IRQHANDLER(DMA1_Channel6, 5, 5)
+#endif
+#if defined(DMA1_Channel7_BASE)
+DMA_IRQHANDLER(DMA1_Channel7, 6, 6)
+#endif
+#if defined(DMA1_Channel8_BASE)
+DMA_IRQHANDLER(DMA1_Channel8, 7, 7)
+#endif
+#if defined(DMA2_Channel1_BASE)
+DMA_IRQHANDLER(DMA2_Channel1, 8, 8)
+#endif
+#if defined(DMA2_Channel2_BASE)
+DMA_IRQHANDLER(DMA2_Channel2, 9, 9)
+#endif
+#if defined(DMA2_Channel3_BASE)
+DMA_IRQHANDLER(DMA2_Channel3, 10, 10)
+#endif
+#if defined(STM32F1xx) && defined(DMA2_Channel4_BASE) && !defined(STM32F105xC) && !defined(STM32F107xC)
+DMA_IRQHANDLER(DMA2_Channel4, 11, 12)
+#else
+#if defined(DMA2_Channel4_BASE)
+DMA_IRQHANDLER(DMA2_Channel4, 11, 11)
+#endif
+#if defined(DMA2_Channel5_BASE)
+DMA_IRQHANDLER(DMA2_Channel5, 12, 12)
+#endif
+#endif /* STM32F1xx && !STM32F105xC && !STM32F107xC */
+#if defined(DMA2_Channel6_BASE)
+DMA_IRQHANDLER(DMA2_Channel6, 13, 13)
+#endif
+#if defined(DMA2_Channel7_BASE)
+DMA_IRQHANDLER(DMA2_Channel7, 14, 14)
+#endif
+#if defined(DMA2_Channel8_BASE)
+DMA_IRQHANDLER(DMA2_Channel8, 15, 15)
+#endif
+#endif /* DMA1_Stream0_BASE */
+#endif /* DMA_IRQ_HANDLER_ENABLED */
+
+#endif /* DMA_WRAPPER_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
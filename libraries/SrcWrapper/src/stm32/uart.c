@@ -14,6 +14,7 @@
 #include "lock_resource.h"
 #include "uart.h"
 #include "Arduino.h"
+#include "stm32yyxx_ll_usart.h"
 #include "PinAF_STM32F1.h"
 
 #ifdef __cplusplus
@@ -35,6 +36,25 @@ extern "C" {
 #if !defined(DEBUG_UART_BAUDRATE)
 #define DEBUG_UART_BAUDRATE 9600
 #endif
+/*
+ * Deferred debug output: when DEBUG_UART_BUFFER_SIZE is not null and the
+ * debug U(S)ART is not used by a Serial instance, uart_debug_write() copies
+ * data in a dedicated ring buffer sent by interrupt (or DMA).
+ */
+#if !defined(DEBUG_UART_BUFFER_SIZE)
+#define DEBUG_UART_BUFFER_SIZE  0
+#endif
+/* Behavior when the debug buffer is full */
+#define DEBUG_UART_DROP_NEW     0 /* Discard the data which do not fit */
+#define DEBUG_UART_DROP_OLD     1 /* Discard the oldest data not being sent */
+#define DEBUG_UART_BLOCK        2 /* Wait for free space (up to TX_TIMEOUT) */
+#if !defined(DEBUG_UART_OVERFLOW)
+#define DEBUG_UART_OVERFLOW     DEBUG_UART_DROP_NEW
+#endif
+/* Optional DMA channel (and request) used to send the debug buffer */
+#if defined(DEBUG_UART_DMA_TX) && !defined(DEBUG_UART_DMA_TX_REQUEST)
+#define DEBUG_UART_DMA_TX_REQUEST 0
+#endif
 
 /* @brief uart characteristics */
 typedef enum {
@@ -78,13 +98,24 @@ typedef enum {
 } uart_index_t;
 
 static UART_HandleTypeDef *uart_handlers[UART_NUM] = {NULL};
+#if DEBUG_UART_BUFFER_SIZE > 0
+static uint8_t debug_tx_buffer[DEBUG_UART_BUFFER_SIZE];
+static volatile uint32_t debug_dropped = 0;
+static volatile uint16_t debug_reserved = 0; /* End of the area reserved by the writers */
+static volatile uint16_t debug_skip = 0;     /* Pending bytes discarded at the end of the transfer */
+static volatile uint8_t debug_writers = 0;   /* Number of writers copying their data */
+#endif
 static serial_t serial_debug = {
   .uart = NP,
   .pin_tx = NC,
   .pin_rx = NC,
   .pin_rts = NC,
   .pin_cts = NC,
-  .index = UART_NUM
+  .index = UART_NUM,
+#if DEBUG_UART_BUFFER_SIZE > 0
+  .tx_buff = debug_tx_buffer,
+  .tx_buff_size = DEBUG_UART_BUFFER_SIZE,
+#endif
 };
 
 /* Aim of the function is to get serial_s pointer using huart pointer */
@@ -349,6 +380,10 @@ void uart_init(serial_t *obj, uint32_t baudrate, uint32_t databits, uint32_t par
 #ifdef UART_ONE_BIT_SAMPLE_DISABLE
   huart->Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
 #endif
+#if defined(USART_CR1_FIFOEN)
+  /* FIFO is disabled by HAL_UART_Init(), see uart_enable_fifo() */
+  huart->FifoMode = UART_FIFOMODE_DISABLE;
+#endif
 
   /* Set the NVIC priority for future interrupts */
   HAL_NVIC_SetPriority(obj->irq, UART_IRQ_PRIO, UART_IRQ_SUBPRIO);
@@ -471,6 +506,25 @@ void uart_init(serial_t *obj, uint32_t baudrate, uint32_t databits, uint32_t par
   */
 void uart_deinit(serial_t *obj)
 {
+  obj->frame_mode = UART_FRAME_NONE;
+  obj->frame_head = obj->frame_tail;
+#if defined(UART_LL_IRQ)
+  obj->ll_rx = 0;
+  obj->ll_tx = 0;
+#endif
+#if defined(UART_DMA_ENABLED)
+  if (obj->rx_dma_size != 0) {
+    obj->rx_dma_size = 0;
+    HAL_UART_AbortReceive(uart_handlers[obj->index]);
+    dma_deinit(&(obj->hdma_rx));
+    obj->handle.hdmarx = NULL;
+  }
+  if (obj->handle.hdmatx != NULL) {
+    HAL_UART_AbortTransmit(uart_handlers[obj->index]);
+    dma_deinit(&(obj->hdma_tx));
+    obj->handle.hdmatx = NULL;
+  }
+#endif
   /* Reset UART and disable clock */
   switch (obj->index) {
 #if defined(USART1_BASE)
@@ -693,7 +747,163 @@ void uart_debug_init(void)
 #endif
     /* serial_debug.pin_rx set by default to NC to configure in half duplex mode */
     uart_init(&serial_debug, DEBUG_UART_BAUDRATE, UART_WORDLENGTH_8B, UART_PARITY_NONE, UART_STOPBITS_1);
+#if (DEBUG_UART_BUFFER_SIZE > 0) && defined(UART_DMA_ENABLED) && defined(DEBUG_UART_DMA_TX)
+    serial_debug.dma_tx = DEBUG_UART_DMA_TX;
+    serial_debug.dma_tx_request = DEBUG_UART_DMA_TX_REQUEST;
+    uart_attach_tx_dma(&serial_debug);
+#endif
+  }
+}
+
+#if DEBUG_UART_BUFFER_SIZE > 0
+static int uart_debug_tx_complete(serial_t *obj);
+
+/**
+  * @brief  Send the next contiguous part of the debug buffer, if any
+  * @note   Called from the U(S)ART interrupt or with interrupts disabled
+  * @param  obj : pointer to serial_t structure
+  * @retval true if a transfer is started
+  */
+static bool uart_debug_tx_start(serial_t *obj)
+{
+  uint16_t head = obj->tx_head;
+  uint16_t tail = obj->tx_tail;
+
+  if (head == tail) {
+    return false;
+  }
+  obj->tx_size = (head > tail) ? head - tail : obj->tx_buff_size - tail;
+  uart_attach_tx_callback(obj, uart_debug_tx_complete, obj->tx_size);
+  return true;
+}
+
+/**
+  * @brief  Debug buffer transfer complete callback
+  * @note   Only owner of tx_tail, which also skips the pending data
+  *         discarded by uart_debug_write_deferred()
+  * @param  obj : pointer to serial_t structure
+  * @retval -1 if a new transfer is started, 0 otherwise
+  */
+static int uart_debug_tx_complete(serial_t *obj)
+{
+  uint32_t tail = obj->tx_tail + obj->tx_size + debug_skip;
+
+  debug_skip = 0;
+  if (tail >= obj->tx_buff_size) {
+    tail -= obj->tx_buff_size;
+  }
+  obj->tx_tail = tail;
+  return uart_debug_tx_start(obj) ? -1 : 0;
+}
+
+/**
+  * @brief  Copy data in the debug buffer and start its transmission
+  * @note   Writers only own tx_head: an area is reserved and published with
+  *         interrupts disabled for a few instructions, the data are copied
+  *         in between. Nested writers (interrupts) publish with the last one.
+  * @param  obj : pointer to serial_t structure
+  * @param  data : data to write
+  * @param  size : number of bytes to write
+  * @retval number of bytes queued
+  */
+static size_t uart_debug_write_deferred(serial_t *obj, uint8_t *data, uint32_t size)
+{
+  uint32_t tickstart = HAL_GetTick();
+  uint32_t primask;
+  uint32_t queued = 0;
+  uint32_t free_size;
+  uint32_t length;
+  uint32_t first;
+  uint32_t limit;
+  uint32_t head;
+  bool published;
+  bool retry;
+
+  while (queued < size) {
+    /* Reserve an area up to the data not sent yet */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    head = debug_reserved;
+    limit = obj->tx_tail;
+    if (serial_tx_active(obj)) {
+      limit += obj->tx_size + debug_skip;
+      if (limit >= obj->tx_buff_size) {
+        limit -= obj->tx_buff_size;
+      }
+    }
+    free_size = (limit > head) ? limit - head - 1 : obj->tx_buff_size - 1 - head + limit;
+#if DEBUG_UART_OVERFLOW == DEBUG_UART_DROP_OLD
+    /*
+     * Data being sent can't be discarded, the pending ones are skipped by
+     * uart_debug_tx_complete(). Not possible when the whole buffer is sent
+     * by uart_ll_irq_handler() (tx_size is null).
+     */
+    if ((free_size < (size - queued)) && serial_tx_active(obj) && (obj->tx_size != 0)) {
+      uint32_t pending = (obj->tx_head >= limit) ? obj->tx_head - limit : obj->tx_buff_size + obj->tx_head - limit;
+      uint32_t drop = ((size - queued) - free_size < pending) ? (size - queued) - free_size : pending;
+      debug_skip += drop;
+      debug_dropped += drop;
+      free_size += drop;
+    }
+    /* Then the oldest new data if still not enough */
+    if (free_size < (size - queued)) {
+      debug_dropped += (size - queued) - free_size;
+      queued = size - free_size;
+    }
+#endif
+    length = (free_size < (size - queued)) ? free_size : (size - queued);
+    debug_reserved = (head + length >= obj->tx_buff_size) ? head + length - obj->tx_buff_size : head + length;
+    debug_writers++;
+    __set_PRIMASK(primask);
+
+    /* Copy with interrupts enabled, in two parts when wrapping */
+    first = (length < obj->tx_buff_size - head) ? length : obj->tx_buff_size - head;
+    memcpy(&obj->tx_buff[head], &data[queued], first);
+    memcpy(obj->tx_buff, &data[queued + first], length - first);
+    queued += length;
+
+    /* Publish the data and start the transmission */
+    retry = false;
+    primask = __get_PRIMASK();
+    __disable_irq();
+    published = (--debug_writers == 0);
+    if (published) {
+      obj->tx_head = debug_reserved;
+      if (!serial_tx_active(obj)) {
+        uart_debug_tx_start(obj);
+      }
+    }
+    if (queued < size) {
+#if DEBUG_UART_OVERFLOW == DEBUG_UART_BLOCK
+      /* Interrupts are required to free some space, and data to be published */
+      retry = published && (primask == 0U) && ((HAL_GetTick() - tickstart) < TX_TIMEOUT);
+#endif
+      if (!retry) {
+        debug_dropped += size - queued;
+      }
+    }
+    __set_PRIMASK(primask);
+
+    if ((queued < size) && !retry) {
+      break;
+    }
   }
+  UNUSED(tickstart);
+  return queued;
+}
+#endif /* DEBUG_UART_BUFFER_SIZE > 0 */
+
+/**
+  * @brief  Number of bytes discarded by the deferred debug output
+  * @retval number of bytes dropped since startup
+  */
+uint32_t uart_debug_dropped(void)
+{
+#if DEBUG_UART_BUFFER_SIZE > 0
+  return debug_dropped;
+#else
+  return 0;
+#endif
 }
 
 /**
@@ -733,6 +943,11 @@ size_t uart_debug_write(uint8_t *data, uint32_t size)
   if (!obj) {
     return 0;
   }
+#if DEBUG_UART_BUFFER_SIZE > 0
+  if (obj == &serial_debug) {
+    return uart_debug_write_deferred(obj, data, size);
+  }
+#endif
 
   while (serial_tx_active(obj)) {
     if ((HAL_GetTick() - tickstart) >= TX_TIMEOUT) {
@@ -766,9 +981,443 @@ uint8_t serial_rx_active(serial_t *obj)
  */
 uint8_t serial_tx_active(serial_t *obj)
 {
+#if defined(UART_LL_IRQ)
+  if (obj->ll_tx) {
+    return 1;
+  }
+#endif
   return ((HAL_UART_GetState(uart_handlers[obj->index]) & HAL_UART_STATE_BUSY_TX) == HAL_UART_STATE_BUSY_TX);
 }
 
+#if defined(USART_CR1_FIFOEN)
+/**
+  * @brief  Enable the hardware FIFO, if the instance has one
+  * @note   Must be called after uart_init() and before starting any transfer.
+  *         Reception then reads the RX FIFO when its threshold is reached
+  *         or on receiver timeout, transmission fills the TX FIFO on its
+  *         threshold (HAL_UART_Transmit_IT() FIFO mode).
+  * @param  obj : pointer to serial_t structure
+  * @retval true if FIFO mode is enabled, false otherwise
+  */
+bool uart_enable_fifo(serial_t *obj)
+{
+  UART_HandleTypeDef *huart;
+
+  if (obj == NULL) {
+    return false;
+  }
+  huart = &(obj->handle);
+  if (!IS_UART_FIFO_INSTANCE(huart->Instance)) {
+    return false;
+  }
+  if ((HAL_UARTEx_SetTxFifoThreshold(huart, UART_FIFO_TX_THRESHOLD) != HAL_OK) ||
+      (HAL_UARTEx_SetRxFifoThreshold(huart, UART_FIFO_RX_THRESHOLD) != HAL_OK) ||
+      (HAL_UARTEx_EnableFifoMode(huart) != HAL_OK)) {
+    return false;
+  }
+  /* Receiver timeout flushes the data below the threshold (not on LPUART) */
+#if defined(LPUART1_BASE)
+  if (!IS_LPUART_INSTANCE(huart->Instance))
+#endif
+  {
+    HAL_UART_ReceiverTimeout_Config(huart, UART_FIFO_RX_TIMEOUT);
+    HAL_UART_EnableReceiverTimeout(huart);
+  }
+  return true;
+}
+
+/**
+  * @brief  Read all the data available in the RX FIFO
+  * @param  huart : pointer on the uart reference
+  * @retval None
+  */
+static void uart_rx_fifo_isr(UART_HandleTypeDef *huart)
+{
+  serial_t *obj = get_serial_obj(huart);
+  uint16_t mask = huart->Mask;
+
+  while (__HAL_UART_GET_FLAG(huart, UART_FLAG_RXFNE) != RESET) {
+    obj->recv = (uint8_t)(huart->Instance->RDR & mask);
+    obj->rx_callback(obj);
+  }
+}
+
+/**
+  * @brief  Start a continuous reception in FIFO mode
+  * @note   HAL_UART_IRQHandler() calls uart_rx_fifo_isr() on FIFO threshold
+  *         and before reporting errors. The receiver timeout is handled by
+  *         uart_rx_timeout_irq() before, as the HAL would abort the
+  *         reception. Overrun aborts it, it is restarted by
+  *         HAL_UART_ErrorCallback().
+  * @param  obj : pointer to serial_t structure
+  * @retval None
+  */
+static void uart_start_rx_fifo(serial_t *obj)
+{
+  UART_HandleTypeDef *huart = &(obj->handle);
+
+  UART_MASK_COMPUTATION(huart);
+  huart->ErrorCode = HAL_UART_ERROR_NONE;
+  huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+  huart->RxISR = uart_rx_fifo_isr;
+  huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+  __HAL_UART_ENABLE_IT(huart, UART_IT_ERR);
+  if (huart->Init.Parity != UART_PARITY_NONE) {
+    __HAL_UART_ENABLE_IT(huart, UART_IT_PE);
+  }
+  if (READ_BIT(huart->Instance->CR2, USART_CR2_RTOEN) != 0U) {
+    __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_RTOF);
+    __HAL_UART_ENABLE_IT(huart, UART_IT_RTO);
+    __HAL_UART_ENABLE_IT(huart, UART_IT_RXFT);
+  } else {
+    /* No receiver timeout: interrupt as soon as the FIFO is not empty */
+    __HAL_UART_ENABLE_IT(huart, UART_IT_RXNE);
+  }
+}
+#endif /* USART_CR1_FIFOEN */
+
+#if defined(UART_LL_IRQ)
+/**
+  * @brief  Start the reception handled by uart_ll_irq_handler()
+  * @note   RxState is kept ready so that the HAL ignores the data register,
+  *         a HAL reception started with getHandle() takes precedence.
+  * @param  obj : pointer to serial_t structure
+  * @retval None
+  */
+static void uart_start_rx_ll(serial_t *obj)
+{
+  UART_HandleTypeDef *huart = &(obj->handle);
+
+  /* Parity bit is received as the most significant data bit */
+  obj->rx_mask = 0xFF;
+  if (huart->Init.Parity != UART_PARITY_NONE) {
+    obj->rx_mask = 0x7F;
+#ifdef UART_WORDLENGTH_7B
+    if (huart->Init.WordLength == UART_WORDLENGTH_7B) {
+      obj->rx_mask = 0x3F;
+    }
+#endif
+  }
+#if !defined(STM32F1xx) && !defined(STM32F2xx) && !defined(STM32F4xx) && !defined(STM32L1xx)
+  huart->RxISR = NULL;
+#endif
+  obj->ll_rx = 1;
+
+  LL_USART_EnableIT_ERROR(obj->uart);
+  if (huart->Init.Parity != UART_PARITY_NONE) {
+    LL_USART_EnableIT_PE(obj->uart);
+  }
+#if defined(USART_CR2_RTOEN)
+  /* Receiver timeout is used in FIFO and frame modes */
+  if (READ_BIT(obj->uart->CR2, USART_CR2_RTOEN) != 0U) {
+    LL_USART_ClearFlag_RTO(obj->uart);
+    LL_USART_EnableIT_RTO(obj->uart);
+  }
+#endif
+#if defined(USART_CR1_FIFOEN)
+  if ((READ_BIT(obj->uart->CR1, USART_CR1_FIFOEN) != 0U) &&
+      (READ_BIT(obj->uart->CR2, USART_CR2_RTOEN) != 0U)) {
+    LL_USART_EnableIT_RXFT(obj->uart);
+  } else
+#endif
+  {
+    LL_USART_EnableIT_RXNE(obj->uart);
+  }
+}
+
+/**
+  * @brief  Lean interrupt handler working directly on the serial_t buffers
+  * @param  obj : pointer to serial_t structure
+  * @retval true if nothing is left for HAL_UART_IRQHandler()
+  */
+static inline bool uart_ll_irq_handler(serial_t *obj)
+{
+  USART_TypeDef *uart = obj->uart;
+  UART_HandleTypeDef *huart = &(obj->handle);
+
+  if (obj->ll_rx && (huart->RxState == HAL_UART_STATE_READY)) {
+    /*
+     * Received data are kept, as in HAL mode.
+     * Error flags are cleared by reading SR then DR on legacy U(S)ART.
+     */
+    if (LL_USART_IsActiveFlag_PE(uart)) {
+      obj->stats.parity_errors++;
+#if !defined(STM32F1xx) && !defined(STM32F2xx) && !defined(STM32F4xx) && !defined(STM32L1xx)
+      LL_USART_ClearFlag_PE(uart);
+#endif
+    }
+    if (LL_USART_IsActiveFlag_FE(uart)) {
+      obj->stats.framing_errors++;
+#if !defined(STM32F1xx) && !defined(STM32F2xx) && !defined(STM32F4xx) && !defined(STM32L1xx)
+      LL_USART_ClearFlag_FE(uart);
+#endif
+    }
+    if (LL_USART_IsActiveFlag_NE(uart)) {
+      obj->stats.noise_errors++;
+#if !defined(STM32F1xx) && !defined(STM32F2xx) && !defined(STM32F4xx) && !defined(STM32L1xx)
+      LL_USART_ClearFlag_NE(uart);
+#endif
+    }
+    if (LL_USART_IsActiveFlag_ORE(uart)) {
+      obj->stats.overrun_errors++;
+#if !defined(STM32F1xx) && !defined(STM32F2xx) && !defined(STM32F4xx) && !defined(STM32L1xx)
+      LL_USART_ClearFlag_ORE(uart);
+#endif
+    }
+#if defined(USART_ISR_RTOF)
+    if (LL_USART_IsActiveFlag_RTO(uart)) {
+      LL_USART_ClearFlag_RTO(uart);
+    }
+#endif
+    while (LL_USART_IsActiveFlag_RXNE(uart)) {
+      uint8_t c = LL_USART_ReceiveData8(uart) & obj->rx_mask;
+      uint16_t i = obj->rx_head + 1;
+      if (i == obj->rx_buff_size) {
+        i = 0;
+      }
+      obj->stats.rx_bytes++;
+      /* Data are dropped if the buffer is full */
+      if (i != obj->rx_tail) {
+        obj->rx_buff[obj->rx_head] = c;
+        obj->rx_head = i;
+      } else {
+        obj->stats.rx_overflows++;
+      }
+    }
+    serial_stats_rx_peak(obj);
+  }
+
+  if (obj->ll_tx) {
+    if (LL_USART_IsEnabledIT_TXE(uart) && LL_USART_IsActiveFlag_TXE(uart)) {
+      uint16_t tail = obj->tx_tail;
+      while ((tail != obj->tx_head) && LL_USART_IsActiveFlag_TXE(uart)) {
+        LL_USART_TransmitData8(uart, obj->tx_buff[tail]);
+        obj->stats.tx_bytes++;
+        if (++tail == obj->tx_buff_size) {
+          tail = 0;
+        }
+      }
+      obj->tx_tail = tail;
+      if (tail == obj->tx_head) {
+        /* Wait for the end of the last frame */
+        LL_USART_DisableIT_TXE(uart);
+        LL_USART_EnableIT_TC(uart);
+      }
+    } else if (LL_USART_IsEnabledIT_TC(uart) && LL_USART_IsActiveFlag_TC(uart)) {
+      LL_USART_DisableIT_TC(uart);
+      if (obj->tx_tail != obj->tx_head) {
+        LL_USART_EnableIT_TXE(uart);
+      } else {
+        obj->ll_tx = 0;
+        huart->gState = HAL_UART_STATE_READY;
+      }
+    }
+  }
+
+  /* HAL is still required for its own transfers (DMA, getHandle()...) */
+#if defined(USART_CR3_WUFIE)
+  if (READ_BIT(uart->CR3, USART_CR3_WUFIE) != 0U) {
+    return false;
+  }
+#endif
+  return (huart->RxState == HAL_UART_STATE_READY) &&
+         (obj->ll_tx || (huart->gState == HAL_UART_STATE_READY));
+}
+#endif /* UART_LL_IRQ */
+
+/**
+  * @brief  Enable the frame mode, reception must be started
+  * @note   A frame ends when the line stays idle for gap bit durations
+  *         (receiver timeout) or for one character if gap is 0 or if the
+  *         receiver timeout is not available (legacy U(S)ART, LPUART, DMA).
+  * @param  obj : pointer to serial_t structure
+  * @param  gap : minimum idle time between two frames, in bit duration
+  * @retval End of frame detection used (UART_FRAME_xxx)
+  */
+uint8_t uart_enable_frame(serial_t *obj, uint32_t gap)
+{
+  UART_HandleTypeDef *huart;
+
+  if (obj == NULL) {
+    return UART_FRAME_NONE;
+  }
+  huart = &(obj->handle);
+
+  /* Must disable interrupt to prevent handle lock contention */
+  HAL_NVIC_DisableIRQ(obj->irq);
+  obj->frame_head = obj->frame_tail;
+  obj->frame_start = obj->rx_head;
+  obj->frame_mode = UART_FRAME_IDLE;
+#if defined(USART_CR2_RTOEN)
+  /* Receiver timeout aborts the DMA reception */
+#if defined(UART_DMA_ENABLED)
+  if (obj->rx_dma_size == 0)
+#endif
+#if defined(LPUART1_BASE)
+    if (!IS_LPUART_INSTANCE(huart->Instance))
+#endif
+      if (gap != 0) {
+        HAL_UART_ReceiverTimeout_Config(huart, gap);
+        HAL_UART_EnableReceiverTimeout(huart);
+        /* Bit is reserved on U(S)ART without receiver timeout */
+        if (READ_BIT(huart->Instance->CR2, USART_CR2_RTOEN) != 0U) {
+          __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_RTOF);
+          __HAL_UART_ENABLE_IT(huart, UART_IT_RTO);
+          obj->frame_mode = UART_FRAME_TIMEOUT;
+        }
+      }
+#else
+  UNUSED(gap);
+#endif
+  if (obj->frame_mode == UART_FRAME_IDLE) {
+#if !defined(STM32F1xx) && !defined(STM32F2xx) && !defined(STM32F4xx) && !defined(STM32L1xx)
+    __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_IDLEF);
+#endif
+    __HAL_UART_ENABLE_IT(huart, UART_IT_IDLE);
+  }
+  HAL_NVIC_EnableIRQ(obj->irq);
+  return obj->frame_mode;
+}
+
+/**
+  * @brief  Check if an end of frame is signaled
+  * @param  obj : pointer to serial_t structure
+  * @retval true if a frame is complete
+  */
+static inline bool uart_frame_event(serial_t *obj)
+{
+  USART_TypeDef *uart = obj->uart;
+
+  if (obj->frame_mode == UART_FRAME_IDLE) {
+    return (READ_BIT(uart->CR1, USART_CR1_IDLEIE) != 0U) &&
+           (__HAL_UART_GET_FLAG(&(obj->handle), UART_FLAG_IDLE) != RESET);
+  }
+#if defined(USART_ISR_RTOF)
+  if (obj->frame_mode == UART_FRAME_TIMEOUT) {
+    return (READ_BIT(uart->CR1, USART_CR1_RTOIE) != 0U) &&
+           (READ_BIT(uart->ISR, USART_ISR_RTOF) != 0U);
+  }
+#endif
+  return false;
+}
+
+/**
+  * @brief  Queue the frame ending at rx_head
+  * @note   Called once the received data are stored in the rx buffer
+  * @param  obj : pointer to serial_t structure
+  * @retval None
+  */
+static void uart_frame_end(serial_t *obj)
+{
+  UART_HandleTypeDef *huart = &(obj->handle);
+  uint16_t end, length;
+  uint32_t timestamp;
+  uint8_t i;
+
+  /* Clear the flags not handled by the HAL (or LL) handler */
+  if (__HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE) != RESET) {
+#if defined(STM32F1xx) || defined(STM32F2xx) || defined(STM32F4xx) || defined(STM32L1xx)
+    /* Cleared by reading SR then DR: keep a pending data for the handler */
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_RXNE) == RESET) {
+      __HAL_UART_CLEAR_IDLEFLAG(huart);
+    }
+#else
+    __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_IDLEF);
+#endif
+  }
+#if defined(USART_ISR_RTOF)
+  __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_RTOF);
+#endif
+#if defined(USART_CR1_FIFOEN) && !defined(UART_LL_IRQ)
+  /* Idle line is detected before the data below the FIFO threshold */
+  if (huart->RxISR == uart_rx_fifo_isr) {
+    uart_rx_fifo_isr(huart);
+  }
+#endif
+
+  end = obj->rx_head;
+  length = (end >= obj->frame_start) ? end - obj->frame_start :
+           obj->rx_buff_size + end - obj->frame_start;
+  if (length == 0) {
+    return;
+  }
+  obj->frame_start = end;
+  timestamp = micros();
+  /* If the queue is full, the frame is merged with the next one */
+  i = obj->frame_head + 1;
+  if (i == UART_FRAME_QUEUE_SIZE) {
+    i = 0;
+  }
+  if (i != obj->frame_tail) {
+    obj->frame_end[obj->frame_head] = end;
+    obj->frame_time[obj->frame_head] = timestamp;
+    obj->frame_head = i;
+  }
+  if (obj->frame_callback != NULL) {
+    obj->frame_callback(length, timestamp);
+  }
+}
+
+#if defined(USART_ISR_RTOF)
+/**
+  * @brief  Receiver timeout of the FIFO or frame mode reception: the FIFO is
+  *         read and the flag cleared before HAL_UART_IRQHandler(), which
+  *         handles it as an error aborting the reception.
+  *         A timeout enabled by a HAL reception started with getHandle() is
+  *         left to the HAL.
+  * @param  obj : pointer to serial_t structure
+  * @retval None
+  */
+static inline void uart_rx_timeout_irq(serial_t *obj)
+{
+  UART_HandleTypeDef *huart = &(obj->handle);
+  bool fifo = false;
+
+  if ((READ_BIT(obj->uart->CR1, USART_CR1_RTOIE) == 0U) ||
+      (READ_BIT(obj->uart->ISR, USART_ISR_RTOF) == 0U)) {
+    return;
+  }
+#if defined(USART_CR1_FIFOEN)
+  fifo = (huart->RxISR == uart_rx_fifo_isr);
+#endif
+  if (fifo || (obj->frame_mode == UART_FRAME_TIMEOUT)) {
+    __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_RTOF);
+#if defined(USART_CR1_FIFOEN)
+    if (fifo) {
+      uart_rx_fifo_isr(huart);
+    }
+#endif
+  }
+}
+#endif /* USART_ISR_RTOF */
+
+/**
+  * @brief  Common U(S)ART interrupt handler
+  * @param  huart : pointer on the uart reference
+  * @retval None
+  */
+static inline void uart_irq_handler(UART_HandleTypeDef *huart)
+{
+  serial_t *obj = get_serial_obj(huart);
+  /* Read before the handlers clear the flags */
+  bool frame = (obj->frame_mode != UART_FRAME_NONE) && uart_frame_event(obj);
+
+#if defined(USART_ISR_RTOF)
+  uart_rx_timeout_irq(obj);
+#endif
+
+#if defined(UART_LL_IRQ)
+  if (!uart_ll_irq_handler(obj))
+#endif
+  {
+    HAL_UART_IRQHandler(huart);
+  }
+  if (frame) {
+    uart_frame_end(obj);
+  }
+}
+
 /**
   * @brief  Read receive byte from uart
   * @param  obj : pointer to serial_t structure
@@ -780,6 +1429,13 @@ int uart_getc(serial_t *obj, unsigned char *c)
     return -1;
   }
 
+#if defined(USART_CR1_FIFOEN)
+  if (obj->handle.RxISR == uart_rx_fifo_isr) {
+    /* Reception is continuous, nothing to restart */
+    *c = (unsigned char)(obj->recv);
+    return 0;
+  }
+#endif
   if (serial_rx_active(obj)) {
     return -1; /* Transaction ongoing */
   }
@@ -813,12 +1469,136 @@ void uart_attach_rx_callback(serial_t *obj, void (*callback)(serial_t *))
   /* Must disable interrupt to prevent handle lock contention */
   HAL_NVIC_DisableIRQ(obj->irq);
 
-  HAL_UART_Receive_IT(uart_handlers[obj->index], &(obj->recv), 1);
+#if defined(UART_LL_IRQ)
+  uart_start_rx_ll(obj);
+#else
+#if defined(USART_CR1_FIFOEN)
+  if (READ_BIT(obj->uart->CR1, USART_CR1_FIFOEN) != 0U) {
+    uart_start_rx_fifo(obj);
+  } else
+#endif
+  {
+    HAL_UART_Receive_IT(uart_handlers[obj->index], &(obj->recv), 1);
+  }
+#endif
 
   /* Enable interrupt */
   HAL_NVIC_EnableIRQ(obj->irq);
 }
 
+#if defined(UART_DMA_ENABLED)
+/**
+  * @brief  Start the circular DMA reception in the rx buffer
+  * @param  obj : pointer to serial_t structure
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef uart_start_rx_dma(serial_t *obj)
+{
+  UART_HandleTypeDef *huart = uart_handlers[obj->index];
+  HAL_StatusTypeDef status;
+
+  /* IDLE line, half and full buffer events move the head */
+  status = HAL_UARTEx_ReceiveToIdle_DMA(huart, obj->rx_buff, obj->rx_dma_size);
+  if (status == HAL_OK) {
+    /*
+     * Line errors would abort the circular reception: do not raise them,
+     * the received data are stored as in interrupt mode.
+     */
+    __HAL_UART_DISABLE_IT(huart, UART_IT_ERR);
+    __HAL_UART_DISABLE_IT(huart, UART_IT_PE);
+  }
+  return status;
+}
+
+/**
+ * Begin asynchronous RX transfer using a circular DMA on the rx buffer.
+ * The rx head is updated on IDLE line, half and full buffer events.
+ * Unlike interrupt mode, unread data are overwritten if the buffer is full,
+ * so its size must cover the maximum latency of the application.
+ *
+ * @param obj : pointer to serial_t structure
+ * @param size : size of the rx buffer
+ * @retval true if DMA reception is started, false otherwise (interrupt mode
+ *         has to be used)
+ */
+bool uart_attach_rx_dma(serial_t *obj, uint16_t size)
+{
+  HAL_StatusTypeDef status;
+
+  if ((obj == NULL) || (obj->dma_rx == NULL) || (size == 0)) {
+    return false;
+  }
+  /* Exit if a reception is already on-going */
+  if (serial_rx_active(obj)) {
+    return false;
+  }
+  /* 9 bits data would require a 16 bits buffer */
+  if ((obj->handle.Init.WordLength == UART_WORDLENGTH_9B) &&
+      (obj->handle.Init.Parity == UART_PARITY_NONE)) {
+    return false;
+  }
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  /* Buffer is invalidated from the data cache, it must be aligned on a line */
+  if (((uint32_t)obj->rx_buff & (DMA_DCACHE_LINE_SIZE - 1U)) != 0U) {
+    return false;
+  }
+#endif
+  if (!dma_init(&(obj->hdma_rx), obj->dma_rx, obj->dma_rx_request,
+                DMA_PERIPH_TO_MEMORY, DMA_CIRCULAR, 1)) {
+    return false;
+  }
+  __HAL_LINKDMA(&(obj->handle), hdmarx, obj->hdma_rx);
+  obj->rx_dma_size = size;
+  obj->rx_head = 0;
+  obj->rx_tail = 0;
+  obj->rx_dma_lapped = 0;
+
+  /* Must disable interrupt to prevent handle lock contention */
+  HAL_NVIC_DisableIRQ(obj->irq);
+
+  status = uart_start_rx_dma(obj);
+
+  /* Enable interrupt */
+  HAL_NVIC_EnableIRQ(obj->irq);
+
+  if (status != HAL_OK) {
+    obj->rx_dma_size = 0;
+    dma_deinit(&(obj->hdma_rx));
+    obj->handle.hdmarx = NULL;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Use DMA for the asynchronous TX transfers instead of TXE interrupt.
+ *
+ * @param obj : pointer to serial_t structure
+ * @retval true if DMA is used for transmission, false otherwise (interrupt
+ *         mode is used)
+ */
+bool uart_attach_tx_dma(serial_t *obj)
+{
+  if ((obj == NULL) || (obj->dma_tx == NULL)) {
+    return false;
+  }
+  if (obj->handle.hdmatx != NULL) {
+    return true;
+  }
+  /* 9 bits data would require a 16 bits buffer */
+  if ((obj->handle.Init.WordLength == UART_WORDLENGTH_9B) &&
+      (obj->handle.Init.Parity == UART_PARITY_NONE)) {
+    return false;
+  }
+  if (!dma_init(&(obj->hdma_tx), obj->dma_tx, obj->dma_tx_request,
+                DMA_MEMORY_TO_PERIPH, DMA_NORMAL, 1)) {
+    return false;
+  }
+  __HAL_LINKDMA(&(obj->handle), hdmatx, obj->hdma_tx);
+  return true;
+}
+#endif /* UART_DMA_ENABLED */
+
 /**
  * Begin asynchronous TX transfer.
  *
@@ -836,8 +1616,26 @@ void uart_attach_tx_callback(serial_t *obj, int (*callback)(serial_t *), size_t
   /* Must disable interrupt to prevent handle lock contention */
   HAL_NVIC_DisableIRQ(obj->irq);
 
-  /* The following function will enable UART_IT_TXE and error interrupts */
-  HAL_UART_Transmit_IT(uart_handlers[obj->index], &obj->tx_buff[obj->tx_tail], size);
+#if defined(UART_DMA_ENABLED)
+  if (obj->handle.hdmatx != NULL) {
+    /* Transfer complete is reported on UART_IT_TC as in interrupt mode */
+    dma_clean_dcache(&obj->tx_buff[obj->tx_tail], size);
+    HAL_UART_Transmit_DMA(uart_handlers[obj->index], &obj->tx_buff[obj->tx_tail], size);
+  } else
+#endif
+  {
+#if defined(UART_LL_IRQ)
+    /* The whole tx buffer is sent by uart_ll_irq_handler() */
+    obj->tx_size = 0;
+    obj->ll_tx = 1;
+    obj->handle.gState = HAL_UART_STATE_BUSY;
+    LL_USART_EnableIT_TXE(obj->uart);
+    UNUSED(size);
+#else
+    /* The following function will enable UART_IT_TXE and error interrupts */
+    HAL_UART_Transmit_IT(uart_handlers[obj->index], &obj->tx_buff[obj->tx_tail], size);
+#endif
+  }
 
   /* Enable interrupt */
   HAL_NVIC_EnableIRQ(obj->irq);
@@ -918,6 +1716,28 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
   }
 }
 
+/**
+  * @brief  Count the line errors reported by the HAL
+  * @param  obj : pointer to serial_t structure
+  * @param  error : HAL_UART_ERROR_xxx bitfield
+  * @retval None
+  */
+static inline void uart_stats_errors(serial_t *obj, uint32_t error)
+{
+  if (error & HAL_UART_ERROR_PE) {
+    obj->stats.parity_errors++;
+  }
+  if (error & HAL_UART_ERROR_FE) {
+    obj->stats.framing_errors++;
+  }
+  if (error & HAL_UART_ERROR_NE) {
+    obj->stats.noise_errors++;
+  }
+  if (error & HAL_UART_ERROR_ORE) {
+    obj->stats.overrun_errors++;
+  }
+}
+
 /**
   * @brief  error callback from UART
   * @param  UartHandle pointer on the uart reference
@@ -948,10 +1768,88 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 #endif
   /* Restart receive interrupt after any error */
   serial_t *obj = get_serial_obj(huart);
+  if (obj) {
+    uart_stats_errors(obj, huart->ErrorCode);
+  }
+#if defined(UART_DMA_ENABLED)
+  if (obj && (huart->hdmatx != NULL) && (huart->ErrorCode & HAL_UART_ERROR_DMA) &&
+      !serial_tx_active(obj)) {
+    /* Transmission has been aborted: skip the current part, send the next one */
+    obj->tx_callback(obj);
+  }
+  if (obj && (obj->rx_dma_size != 0)) {
+    /* Circular reception has been aborted, pending data are lost */
+    if (!serial_rx_active(obj)) {
+      obj->rx_head = 0;
+      obj->rx_tail = 0;
+      obj->rx_dma_lapped = 0;
+      obj->frame_start = 0;
+      obj->frame_head = obj->frame_tail;
+      uart_start_rx_dma(obj);
+    }
+    return;
+  }
+#endif
   if (obj && !serial_rx_active(obj)) {
-    HAL_UART_Receive_IT(huart, &(obj->recv), 1);
+#if defined(UART_LL_IRQ)
+    uart_start_rx_ll(obj);
+#else
+#if defined(USART_CR1_FIFOEN)
+    if (READ_BIT(huart->Instance->CR1, USART_CR1_FIFOEN) != 0U) {
+      uart_start_rx_fifo(obj);
+    } else
+#endif
+    {
+      HAL_UART_Receive_IT(huart, &(obj->recv), 1);
+    }
+#endif
+  }
+}
+
+#if defined(UART_DMA_ENABLED)
+/**
+  * @brief  Reception event callback (IDLE line, half and full buffer)
+  * @param  huart pointer on the uart reference
+  * @param  Size position of the DMA in the rx buffer
+  * @retval None
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  serial_t *obj = get_serial_obj(huart);
+  if (obj && (obj->rx_dma_size != 0)) {
+    uint16_t head = (Size < obj->rx_dma_size) ? Size : 0;
+    uint16_t pending = (obj->rx_head >= obj->rx_tail) ? obj->rx_head - obj->rx_tail :
+                       obj->rx_dma_size + obj->rx_head - obj->rx_tail;
+    uint16_t received = (head >= obj->rx_head) ? head - obj->rx_head :
+                        obj->rx_dma_size + head - obj->rx_head;
+
+    /* Buffer is full until the reader resynchronizes after a lap */
+    if (obj->rx_dma_lapped) {
+      pending = obj->rx_dma_size - 1U;
+    }
+
+    /* Error interrupts are disabled, count (and clear) the flags here */
+    uart_stats_errors(obj,
+                      ((__HAL_UART_GET_FLAG(huart, UART_FLAG_PE) != RESET) ? HAL_UART_ERROR_PE : 0) |
+                      ((__HAL_UART_GET_FLAG(huart, UART_FLAG_FE) != RESET) ? HAL_UART_ERROR_FE : 0) |
+                      ((__HAL_UART_GET_FLAG(huart, UART_FLAG_NE) != RESET) ? HAL_UART_ERROR_NE : 0) |
+                      ((__HAL_UART_GET_FLAG(huart, UART_FLAG_ORE) != RESET) ? HAL_UART_ERROR_ORE : 0));
+#if !defined(STM32F1xx) && !defined(STM32F2xx) && !defined(STM32F4xx) && !defined(STM32L1xx)
+    __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_PEF | UART_CLEAR_FEF | UART_CLEAR_NEF | UART_CLEAR_OREF);
+#endif
+    dma_invalidate_dcache(obj->rx_buff, obj->rx_dma_size);
+    obj->stats.rx_bytes += received;
+    /* Unread data overwritten by the circular DMA: the tail is only written
+     * by the reader, it moves it after the head to keep the newest data */
+    if (received > obj->rx_dma_size - 1U - pending) {
+      obj->stats.rx_overflows += received - (obj->rx_dma_size - 1U - pending);
+      obj->rx_dma_lapped = 1;
+    }
+    obj->rx_head = head;
+    serial_stats_rx_peak(obj);
   }
 }
+#endif /* UART_DMA_ENABLED */
 
 /**
   * @brief  USART 1 IRQ handler
@@ -962,7 +1860,7 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 void USART1_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(USART1_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART1_INDEX]);
+  uart_irq_handler(uart_handlers[UART1_INDEX]);
 }
 #endif
 
@@ -976,11 +1874,11 @@ void USART2_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(USART2_IRQn);
   if (uart_handlers[UART2_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[UART2_INDEX]);
+    uart_irq_handler(uart_handlers[UART2_INDEX]);
   }
 #if defined(STM32G0xx) && defined(LPUART2_BASE)
   if (uart_handlers[LPUART2_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[LPUART2_INDEX]);
+    uart_irq_handler(uart_handlers[LPUART2_INDEX]);
   }
 #endif
 }
@@ -997,43 +1895,43 @@ void USART3_IRQHandler(void)
   HAL_NVIC_ClearPendingIRQ(USART3_IRQn);
 #if defined(STM32F091xC) || defined (STM32F098xx)
   if (__HAL_GET_PENDING_IT(HAL_ITLINE_USART3) != RESET) {
-    HAL_UART_IRQHandler(uart_handlers[UART3_INDEX]);
+    uart_irq_handler(uart_handlers[UART3_INDEX]);
   }
   if (__HAL_GET_PENDING_IT(HAL_ITLINE_USART4) != RESET) {
-    HAL_UART_IRQHandler(uart_handlers[UART4_INDEX]);
+    uart_irq_handler(uart_handlers[UART4_INDEX]);
   }
   if (__HAL_GET_PENDING_IT(HAL_ITLINE_USART5) != RESET) {
-    HAL_UART_IRQHandler(uart_handlers[UART5_INDEX]);
+    uart_irq_handler(uart_handlers[UART5_INDEX]);
   }
   if (__HAL_GET_PENDING_IT(HAL_ITLINE_USART6) != RESET) {
-    HAL_UART_IRQHandler(uart_handlers[UART6_INDEX]);
+    uart_irq_handler(uart_handlers[UART6_INDEX]);
   }
   if (__HAL_GET_PENDING_IT(HAL_ITLINE_USART7) != RESET) {
-    HAL_UART_IRQHandler(uart_handlers[UART7_INDEX]);
+    uart_irq_handler(uart_handlers[UART7_INDEX]);
   }
   if (__HAL_GET_PENDING_IT(HAL_ITLINE_USART8) != RESET) {
-    HAL_UART_IRQHandler(uart_handlers[UART8_INDEX]);
+    uart_irq_handler(uart_handlers[UART8_INDEX]);
   }
 #else
   if (uart_handlers[UART3_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[UART3_INDEX]);
+    uart_irq_handler(uart_handlers[UART3_INDEX]);
   }
 #if defined(STM32F0xx) || defined(STM32G0xx)
   /* USART3_4_IRQn */
   if (uart_handlers[UART4_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[UART4_INDEX]);
+    uart_irq_handler(uart_handlers[UART4_INDEX]);
   }
 #if defined(STM32F030xC) || defined(STM32G0xx) && (defined(LPUART2_BASE) || defined(USART5_BASE))
   if (uart_handlers[UART5_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[UART5_INDEX]);
+    uart_irq_handler(uart_handlers[UART5_INDEX]);
   }
   if (uart_handlers[UART6_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[UART6_INDEX]);
+    uart_irq_handler(uart_handlers[UART6_INDEX]);
   }
 #endif /* STM32F030xC */
 #if defined(STM32G0xx) && defined(LPUART1_BASE)
   if (uart_handlers[LPUART1_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[LPUART1_INDEX]);
+    uart_irq_handler(uart_handlers[LPUART1_INDEX]);
   }
 #endif /* STM32G0xx && LPUART1_BASE */
 #endif /* STM32F0xx || STM32G0xx */
@@ -1050,7 +1948,7 @@ void USART3_IRQHandler(void)
 void UART4_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(UART4_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART4_INDEX]);
+  uart_irq_handler(uart_handlers[UART4_INDEX]);
 }
 #endif
 
@@ -1065,10 +1963,10 @@ void USART4_5_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(USART4_IRQn);
   if (uart_handlers[UART4_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[UART4_INDEX]);
+    uart_irq_handler(uart_handlers[UART4_INDEX]);
   }
   if (uart_handlers[UART5_INDEX] != NULL) {
-    HAL_UART_IRQHandler(uart_handlers[UART5_INDEX]);
+    uart_irq_handler(uart_handlers[UART5_INDEX]);
   }
 }
 #endif
@@ -1083,7 +1981,7 @@ void USART4_5_IRQHandler(void)
 void UART5_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(UART5_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART5_INDEX]);
+  uart_irq_handler(uart_handlers[UART5_INDEX]);
 }
 #endif
 
@@ -1096,7 +1994,7 @@ void UART5_IRQHandler(void)
 void USART6_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(USART6_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART6_INDEX]);
+  uart_irq_handler(uart_handlers[UART6_INDEX]);
 }
 #endif
 
@@ -1109,7 +2007,7 @@ void USART6_IRQHandler(void)
 void LPUART1_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(LPUART1_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[LPUART1_INDEX]);
+  uart_irq_handler(uart_handlers[LPUART1_INDEX]);
 }
 #endif
 
@@ -1122,7 +2020,7 @@ void LPUART1_IRQHandler(void)
 void UART7_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(UART7_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART7_INDEX]);
+  uart_irq_handler(uart_handlers[UART7_INDEX]);
 }
 #endif
 
@@ -1135,7 +2033,7 @@ void UART7_IRQHandler(void)
 void UART8_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(UART8_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART8_INDEX]);
+  uart_irq_handler(uart_handlers[UART8_INDEX]);
 }
 #endif
 
@@ -1148,7 +2046,7 @@ void UART8_IRQHandler(void)
 void UART9_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(UART9_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART9_INDEX]);
+  uart_irq_handler(uart_handlers[UART9_INDEX]);
 }
 #endif
 
@@ -1161,7 +2059,7 @@ void UART9_IRQHandler(void)
 void UART10_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(UART10_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART10_INDEX]);
+  uart_irq_handler(uart_handlers[UART10_INDEX]);
 }
 #endif
 
@@ -1174,7 +2072,7 @@ void UART10_IRQHandler(void)
 void USART10_IRQHandler(void)
 {
   HAL_NVIC_ClearPendingIRQ(USART10_IRQn);
-  HAL_UART_IRQHandler(uart_handlers[UART10_INDEX]);
+  uart_irq_handler(uart_handlers[UART10_INDEX]);
 }
 #endif
 
@@ -0,0 +1,83 @@
+/*
+  I2C bus manager
+
+  Two sensors share the I2C bus: a humidity sensor (HTS221) and a pressure
+  sensor (LPS22HB), as on the B-L475E-IOT01A board. Their register reads
+  are queued and run back to back from the I2C interrupt, while the loop
+  is free for other work.
+
+  With I2C_DMA_ENABLED defined and DMA channels set with Wire.setTxDMA() and
+  Wire.setRxDMA(), the longest transfers use the DMA.
+
+  This example code is in the public domain.
+*/
+
+#include <WireBus.h>
+
+#define HTS221_ADDRESS   0x5F
+#define LPS22HB_ADDRESS  0x5D
+#define WHO_AM_I         0x0F
+// HTS221 humidity/temperature output registers, address auto-increment
+#define HTS221_OUT       (0x28 | 0x80)
+// LPS22HB pressure/temperature output registers
+#define LPS22HB_OUT      0x28
+
+WireBus bus(Wire);
+
+static uint8_t hts221_id;
+static uint8_t lps22hb_id;
+static uint8_t hts221_data[4];
+static uint8_t lps22hb_data[5];
+static volatile uint32_t samples = 0;
+static volatile uint32_t errors = 0;
+
+void readDone(void *arg, uint8_t status)
+{
+  (void)arg;
+  if (status == 0) {
+    samples++;
+  } else {
+    errors++;
+  }
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+
+  Wire.begin();
+  Wire.setClock(400000);
+
+  bus.queueRead(HTS221_ADDRESS, WHO_AM_I, 1, &hts221_id, 1);
+  bus.queueRead(LPS22HB_ADDRESS, WHO_AM_I, 1, &lps22hb_id, 1);
+  bus.flush();
+  Serial.print("HTS221 WHO_AM_I: 0x");
+  Serial.println(hts221_id, HEX);
+  Serial.print("LPS22HB WHO_AM_I: 0x");
+  Serial.println(lps22hb_id, HEX);
+}
+
+void loop()
+{
+  uint32_t start = millis();
+  uint32_t computed = 0;
+
+  samples = 0;
+  errors = 0;
+  while (millis() - start < 1000) {
+    // Keep the queue filled, the CPU is free between the calls
+    if (bus.pending() < 2) {
+      bus.queueRead(HTS221_ADDRESS, HTS221_OUT, 1, hts221_data, sizeof(hts221_data), readDone);
+      bus.queueRead(LPS22HB_ADDRESS, LPS22HB_OUT, 1, lps22hb_data, sizeof(lps22hb_data), readDone);
+    }
+    computed++;
+  }
+  bus.flush();
+  Serial.print("Register reads per second: ");
+  Serial.print(samples);
+  Serial.print(", errors: ");
+  Serial.print(errors);
+  Serial.print(", loop iterations: ");
+  Serial.println(computed);
+}
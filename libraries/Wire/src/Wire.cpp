@@ -38,6 +38,15 @@ TwoWire::TwoWire()
   memset((void *)&_i2c, 0, sizeof(_i2c));
   _i2c.sda = digitalPinToPinName(SDA);
   _i2c.scl = digitalPinToPinName(SCL);
+  rxBuffer = nullptr;
+  rxBufferAllocated = 0;
+  rxBufferStatic = false;
+  txBuffer = nullptr;
+  txBufferAllocated = 0;
+  txBufferStatic = false;
+#if defined(I2C_DMA_ENABLED)
+  _i2c.dma_threshold = I2C_DMA_THRESHOLD;
+#endif
 }
 
 TwoWire::TwoWire(uint32_t sda, uint32_t scl)
@@ -45,6 +54,15 @@ TwoWire::TwoWire(uint32_t sda, uint32_t scl)
   memset((void *)&_i2c, 0, sizeof(_i2c));
   _i2c.sda = digitalPinToPinName(sda);
   _i2c.scl = digitalPinToPinName(scl);
+  rxBuffer = nullptr;
+  rxBufferAllocated = 0;
+  rxBufferStatic = false;
+  txBuffer = nullptr;
+  txBufferAllocated = 0;
+  txBufferStatic = false;
+#if defined(I2C_DMA_ENABLED)
+  _i2c.dma_threshold = I2C_DMA_THRESHOLD;
+#endif
 }
 
 /**
@@ -74,18 +92,16 @@ void TwoWire::begin(uint8_t address, bool generalCall, bool NoStretchMode)
 {
   rxBufferIndex = 0;
   rxBufferLength = 0;
-  rxBuffer = nullptr;
-  rxBufferAllocated = 0;
   resetRxBuffer();
 
   txDataSize = 0;
   txAddress = 0;
-  txBuffer = nullptr;
-  txBufferAllocated = 0;
   resetTxBuffer();
 
   _i2c.__this = (void *)this;
   user_onRequest = NULL;
+  user_onComplete = nullptr;
+  asyncQuantity = 0;
   transmitting = 0;
 
   ownAddress = address << 1;
@@ -99,6 +115,9 @@ void TwoWire::begin(uint8_t address, bool generalCall, bool NoStretchMode)
   recoverBus(); // in case I2C bus (device) is stuck after a reset for example
 
   i2c_custom_init(&_i2c, 100000, I2C_ADDRESSINGMODE_7BIT, ownAddress);
+#if defined(I2C_DMA_ENABLED)
+  i2c_attach_dma(&_i2c);
+#endif
 
   if (_i2c.isMaster == 0) {
     // i2c_attachSlaveTxEvent(&_i2c, reinterpret_cast<void(*)(i2c_t*)>(&TwoWire::onRequestService));
@@ -117,16 +136,59 @@ void TwoWire::begin(int address, bool generalCall, bool NoStretchMode)
 void TwoWire::end(void)
 {
   i2c_deinit(&_i2c);
-  if (txBuffer != nullptr) {
-    free(txBuffer);
-    txBuffer = nullptr;
+  // user buffers are kept for the next begin()
+  if (!txBufferStatic) {
+    if (txBuffer != nullptr) {
+      free(txBuffer);
+      txBuffer = nullptr;
+    }
+    txBufferAllocated = 0;
   }
-  txBufferAllocated = 0;
-  if (rxBuffer != nullptr) {
+  if (!rxBufferStatic) {
+    if (rxBuffer != nullptr) {
+      free(rxBuffer);
+      rxBuffer = nullptr;
+    }
+    rxBufferAllocated = 0;
+  }
+}
+
+/**
+  * @brief  Use a user buffer for the received data instead of the heap.
+  *         Reads longer than the buffer fail. To be called before begin(),
+  *         or while no transfer is on-going.
+  * @param  buffer: buffer kept by TwoWire, nullptr to use the heap again
+  * @param  size: size of the buffer in bytes, up to 65535
+  */
+void TwoWire::setRxBuffer(uint8_t *buffer, size_t size)
+{
+  if (!rxBufferStatic && (rxBuffer != nullptr)) {
     free(rxBuffer);
-    rxBuffer = nullptr;
   }
-  rxBufferAllocated = 0;
+  rxBufferStatic = (buffer != nullptr);
+  rxBuffer = buffer;
+  rxBufferAllocated = rxBufferStatic ? ((size > UINT16_MAX) ? UINT16_MAX : size) : 0;
+  rxBufferIndex = 0;
+  rxBufferLength = 0;
+}
+
+/**
+  * @brief  Use a user buffer for the data to transmit instead of the heap.
+  *         write() fails beyond its size, which is not limited to
+  *         WIRE_MAX_TX_BUFF_LENGTH. To be called before begin(), or while
+  *         no transfer is on-going.
+  * @param  buffer: buffer kept by TwoWire, nullptr to use the heap again
+  * @param  size: size of the buffer in bytes, up to 65535
+  */
+void TwoWire::setTxBuffer(uint8_t *buffer, size_t size)
+{
+  if (!txBufferStatic && (txBuffer != nullptr)) {
+    free(txBuffer);
+  }
+  txBufferStatic = (buffer != nullptr);
+  txBuffer = buffer;
+  txBufferAllocated = txBufferStatic ? ((size > UINT16_MAX) ? UINT16_MAX : size) : 0;
+  txDataSize = 0;
 }
 
 void TwoWire::setClock(uint32_t frequency)
@@ -145,9 +207,10 @@ uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint32_t iaddres
 #endif
   uint8_t read = 0;
 
-  if (_i2c.isMaster == 1) {
-    allocateRxBuffer(quantity);
-
+  // Rx buffer could be in use by an asynchronous transfer
+  i2c_master_wait(&_i2c);
+  // a user Rx buffer could be too short
+  if ((_i2c.isMaster == 1) && allocateRxBuffer(quantity)) {
     if (isize > 0) {
       // send internal address; this mode allows sending a repeated start to access
       // some devices' internal registers. This function is executed by the hardware
@@ -215,6 +278,8 @@ uint8_t TwoWire::requestFrom(int address, int quantity, int sendStop)
 
 void TwoWire::beginTransmission(uint8_t address)
 {
+  // Tx buffer could be in use by an asynchronous transfer
+  i2c_master_wait(&_i2c);
   // indicate that we are transmitting
   transmitting = 1;
   // set address of targeted slave
@@ -258,26 +323,7 @@ uint8_t TwoWire::endTransmission(uint8_t sendStop)
 
   if (_i2c.isMaster == 1) {
     // transmit buffer (blocking)
-    switch (i2c_master_write(&_i2c, txAddress, txBuffer, txDataSize)) {
-      case I2C_OK :
-        ret = 0; // Success
-        break;
-      case I2C_DATA_TOO_LONG :
-        ret = 1;
-        break;
-      case I2C_NACK_ADDR:
-        ret = 2;
-        break;
-      case I2C_NACK_DATA:
-        ret = 3;
-        break;
-      case I2C_TIMEOUT:
-      case I2C_BUSY:
-      case I2C_ERROR:
-      default:
-        ret = 4;
-        break;
-    }
+    ret = statusCode(i2c_master_write(&_i2c, txAddress, txBuffer, txDataSize));
 
     // reset Tx buffer
     resetTxBuffer();
@@ -299,6 +345,128 @@ uint8_t TwoWire::endTransmission(void)
   return endTransmission((uint8_t)true);
 }
 
+/**
+  * @brief  Read consecutive registers of a device: the register address is
+  *         sent, then the data are read after a repeated start, straight
+  *         into the buffer.
+  * @param  address: 7-bit address of the device
+  * @param  reg: address of the first register
+  * @param  regSize: register address size in bytes: 1 or 2
+  * @param  buf: buffer filled with the register values
+  * @param  len: number of bytes to read
+  * @retval status, same as endTransmission()
+  */
+uint8_t TwoWire::readRegisters(uint8_t address, uint16_t reg, uint8_t regSize,
+                               uint8_t *buf, size_t len)
+{
+  uint8_t ret = 4;
+
+  if (len > UINT16_MAX) {
+    ret = 1;
+  } else if (_i2c.isMaster == 1) {
+    ret = statusCode(i2c_master_mem_read(&_i2c, address << 1, reg, regSize, buf, len));
+  }
+  return ret;
+}
+
+/**
+  * @brief  Write consecutive registers of a device: the register address
+  *         and the data are sent in a single transfer, straight from the
+  *         buffer.
+  * @param  address: 7-bit address of the device
+  * @param  reg: address of the first register
+  * @param  regSize: register address size in bytes: 1 or 2
+  * @param  buf: register values to write
+  * @param  len: number of bytes to write
+  * @retval status, same as endTransmission()
+  */
+uint8_t TwoWire::writeRegisters(uint8_t address, uint16_t reg, uint8_t regSize,
+                                const uint8_t *buf, size_t len)
+{
+  uint8_t ret = 4;
+
+  if (len > UINT16_MAX) {
+    ret = 1;
+  } else if (_i2c.isMaster == 1) {
+    ret = statusCode(i2c_master_mem_write(&_i2c, address << 1, reg, regSize,
+                                          (uint8_t *)buf, len));
+  }
+  return ret;
+}
+
+/**
+  * @brief  Same as endTransmission() without waiting for the end of the
+  *         transfer. Tx buffer is in use until then, the next
+  *         beginTransmission() waits for it.
+  * @param  callback: function called at the end of the transfer, from the
+  *         interrupt, with the endTransmission() status. Can be nullptr.
+  * @param  sendStop: false to perform a repeated start after the transfer
+  * @retval true if the transfer is started
+  */
+bool TwoWire::endTransmissionAsync(cb_function_async_t callback, bool sendStop)
+{
+  bool ret = false;
+  uint16_t size = txDataSize;
+
+  if ((_i2c.isMaster == 1) && !isBusy()) {
+#if defined(I2C_OTHER_FRAME)
+    _i2c.handle.XferOptions = sendStop ? I2C_OTHER_AND_LAST_FRAME : I2C_OTHER_FRAME;
+#else
+    UNUSED(sendStop);
+#endif
+    user_onComplete = callback;
+    asyncQuantity = 0;
+    // done transmitting, before the callback could begin a new transmission
+    txDataSize = 0;
+    transmitting = 0;
+    ret = (i2c_master_write_async(&_i2c, txAddress, txBuffer, size,
+                                  onCompleteService, this) == I2C_OK);
+  }
+  return ret;
+}
+
+/**
+  * @brief  Same as requestFrom() without waiting for the end of the transfer.
+  *         Received bytes are available() from the callback.
+  * @param  address: 7-bit address of the device
+  * @param  quantity: number of bytes to read
+  * @param  callback: function called at the end of the transfer, from the
+  *         interrupt, with the endTransmission() status. Can be nullptr.
+  * @param  sendStop: false to perform a repeated start after the transfer
+  * @retval true if the transfer is started
+  */
+bool TwoWire::requestFromAsync(uint8_t address, uint16_t quantity,
+                               cb_function_async_t callback, bool sendStop)
+{
+  bool ret = false;
+
+  if ((_i2c.isMaster == 1) && (quantity != 0) && !isBusy() &&
+      allocateRxBuffer(quantity)) {
+#if defined(I2C_OTHER_FRAME)
+    _i2c.handle.XferOptions = sendStop ? I2C_OTHER_AND_LAST_FRAME : I2C_OTHER_FRAME;
+#else
+    UNUSED(sendStop);
+#endif
+    user_onComplete = callback;
+    asyncQuantity = quantity;
+    rxBufferIndex = 0;
+    rxBufferLength = 0;
+    ret = (i2c_master_read_async(&_i2c, address << 1, rxBuffer, quantity,
+                                 onCompleteService, this) == I2C_OK);
+  }
+  return ret;
+}
+
+/**
+  * @brief  Wait for the end of the asynchronous transfer. Can be called from
+  *         the callback.
+  * @retval status of the last asynchronous transfer, same as endTransmission()
+  */
+uint8_t TwoWire::waitForCompletion(void)
+{
+  return statusCode(i2c_master_wait(&_i2c));
+}
+
 // must be called in:
 // slave tx event callback
 // or after beginTransmission(address)
@@ -423,7 +591,10 @@ void TwoWire::onReceiveService(i2c_t *obj)
     // i know this drops data, but it allows for slight stupidity
     // meaning, they may not have read all the master requestFrom() data yet
     if (TW->rxBufferIndex >= TW->rxBufferLength) {
-      TW->allocateRxBuffer(numBytes);
+      // a user buffer can be shorter: data are truncated
+      if (!TW->allocateRxBuffer(numBytes)) {
+        numBytes = TW->rxBufferAllocated;
+      }
 
       // copy twi rx buffer into local read buffer
       // this enables new reads to happen in parallel
@@ -452,6 +623,54 @@ void TwoWire::onRequestService(i2c_t *obj)
   }
 }
 
+// behind the scenes function that is called at the end of an asynchronous transfer
+void TwoWire::onCompleteService(void *arg)
+{
+  TwoWire *TW = (TwoWire *)arg;
+  uint8_t status = statusCode((i2c_status_e)TW->_i2c.async_status);
+  // the callback could start a new transfer
+  cb_function_async_t callback = std::move(TW->user_onComplete);
+
+  TW->user_onComplete = nullptr;
+  if (TW->asyncQuantity != 0) {
+    // set rx buffer iterator vars
+    TW->rxBufferIndex = 0;
+    TW->rxBufferLength = (status == 0) ? TW->asyncQuantity : 0;
+    TW->asyncQuantity = 0;
+  }
+  if (callback) {
+    callback(status);
+  }
+}
+
+// converts the status of a master transfer to the endTransmission() one
+uint8_t TwoWire::statusCode(i2c_status_e status)
+{
+  uint8_t ret;
+
+  switch (status) {
+    case I2C_OK :
+      ret = 0; // Success
+      break;
+    case I2C_DATA_TOO_LONG :
+      ret = 1;
+      break;
+    case I2C_NACK_ADDR:
+      ret = 2;
+      break;
+    case I2C_NACK_DATA:
+      ret = 3;
+      break;
+    case I2C_TIMEOUT:
+    case I2C_BUSY:
+    case I2C_ERROR:
+    default:
+      ret = 4;
+      break;
+  }
+  return ret;
+}
+
 // sets function called on slave write
 void TwoWire::onReceive(cb_function_receive_t function)
 {
@@ -466,12 +685,17 @@ void TwoWire::onRequest(cb_function_request_t function)
 
 /**
   * @brief  Allocate the Rx/Tx buffer to the requested length if needed
-  * @note   Minimum allocated size is BUFFER_LENGTH)
+  * @note   Minimum allocated size is BUFFER_LENGTH). A user buffer is
+  *         never reallocated.
   * @param  length: number of bytes to allocate
+  * @retval false if the user buffer is too short
   */
-void TwoWire::allocateRxBuffer(size_t length)
+bool TwoWire::allocateRxBuffer(size_t length)
 {
-  if (rxBufferAllocated < length) {
+  bool ret = true;
+  if (rxBufferStatic) {
+    ret = (rxBufferAllocated >= length);
+  } else if (rxBufferAllocated < length) {
     // By default we allocate BUFFER_LENGTH bytes. It is the min size of the buffer.
     if (length < BUFFER_LENGTH) {
       length = BUFFER_LENGTH;
@@ -484,12 +708,17 @@ void TwoWire::allocateRxBuffer(size_t length)
       _Error_Handler("No enough memory! (%i)\n", length);
     }
   }
+  return ret;
 }
 
 inline size_t TwoWire::allocateTxBuffer(size_t length)
 {
   size_t ret = length;
-  if (length > WIRE_MAX_TX_BUFF_LENGTH) {
+  if (txBufferStatic) {
+    if (txBufferAllocated < length) {
+      ret = 0;
+    }
+  } else if (length > WIRE_MAX_TX_BUFF_LENGTH) {
     ret = 0;
   } else if (txBufferAllocated < length) {
     // By default we allocate BUFFER_LENGTH bytes. It is the min size of the buffer.
@@ -33,6 +33,7 @@ extern "C" {
 // Minimal buffer length. Buffers length will be increased when needed,
 // but TX buffer is limited to a maximum to avoid too much stack consumption
 // Note: Buffer length and max buffer length are limited by uin16_t type
+// User buffers set with setRxBuffer()/setTxBuffer() are never reallocated
 #define BUFFER_LENGTH 32
 #if !defined(WIRE_MAX_TX_BUFF_LENGTH)
   #define WIRE_MAX_TX_BUFF_LENGTH       1024U
@@ -45,17 +46,21 @@ class TwoWire : public Stream {
   public:
     typedef std::function<void(int)> cb_function_receive_t;
     typedef std::function<void(void)> cb_function_request_t;
+    // Completion of an asynchronous transfer, with the endTransmission() status
+    typedef std::function<void(uint8_t)> cb_function_async_t;
 
   private:
     uint8_t *rxBuffer;
     uint16_t rxBufferAllocated;
     uint16_t rxBufferIndex;
     uint16_t rxBufferLength;
+    bool rxBufferStatic;
 
     uint8_t txAddress;
     uint8_t *txBuffer;
     uint16_t txBufferAllocated;
     uint16_t txDataSize;
+    bool txBufferStatic;
 
     uint8_t transmitting;
 
@@ -65,16 +70,24 @@ class TwoWire : public Stream {
     std::function<void(int)> user_onReceive;
     std::function<void(void)> user_onRequest;
 
+    // Asynchronous transfer: callback and number of bytes requested
+    cb_function_async_t user_onComplete;
+    uint16_t asyncQuantity;
+
     static void onRequestService(i2c_t *);
     static void onReceiveService(i2c_t *);
+    static void onCompleteService(void *);
+    static uint8_t statusCode(i2c_status_e status);
 
-    void allocateRxBuffer(size_t length);
+    bool allocateRxBuffer(size_t length);
     size_t allocateTxBuffer(size_t length);
 
     void resetRxBuffer(void);
     void resetTxBuffer(void);
     void recoverBus(void);
 
+    friend class WireBus;
+
   public:
     TwoWire();
     TwoWire(uint32_t sda, uint32_t scl);
@@ -96,6 +109,44 @@ class TwoWire : public Stream {
     {
       _i2c.sda = sda;
     };
+#if defined(I2C_DMA_ENABLED)
+    // Use DMA for the master transfers of at least I2C_DMA_THRESHOLD bytes,
+    // shorter ones are interrupt driven.
+    // request is the DMA request (or stream channel), unused on series with
+    // fixed DMA mapping. This needs to be done before the call to begin()
+    void setTxDMA(dma_channel_t *instance, uint32_t request = 0)
+    {
+      _i2c.dma_tx = instance;
+      _i2c.dma_tx_request = request;
+    };
+    void setRxDMA(dma_channel_t *instance, uint32_t request = 0)
+    {
+      _i2c.dma_rx = instance;
+      _i2c.dma_rx_request = request;
+    };
+    // Minimum size in bytes of the DMA transfers, 0 to disable the DMA
+    void setDMAThreshold(uint16_t threshold)
+    {
+      _i2c.dma_threshold = threshold;
+    };
+#endif
+    /* Buffers provided by the user, so that transfers never use the heap.
+     * Transfers longer than the buffer fail. This needs to be done before
+     * the call to begin(), nullptr to use the heap again.
+     */
+    void setRxBuffer(uint8_t *buffer, size_t size);
+    void setTxBuffer(uint8_t *buffer, size_t size);
+    // Same, the size of the array being known at compile time
+    template <size_t N> void setRxBuffer(uint8_t (&buffer)[N])
+    {
+      static_assert(N <= UINT16_MAX, "Wire buffer size cannot exceed 65535");
+      setRxBuffer(buffer, N);
+    };
+    template <size_t N> void setTxBuffer(uint8_t (&buffer)[N])
+    {
+      static_assert(N <= UINT16_MAX, "Wire buffer size cannot exceed 65535");
+      setTxBuffer(buffer, N);
+    };
     void begin(bool generalCall = false);
     void begin(uint32_t, uint32_t);
     void begin(uint8_t, bool generalCall = false, bool NoStretchMode = false);
@@ -112,6 +163,34 @@ class TwoWire : public Stream {
     uint8_t requestFrom(uint8_t, uint8_t, uint32_t, uint8_t, uint8_t);
     uint8_t requestFrom(int, int);
     uint8_t requestFrom(int, int, int);
+
+    /* Register access in a single call: the register address (regSize 1 or
+     * 2 bytes, most significant byte first) is sent, then the data are sent
+     * in the same transfer, or read after a repeated start. Data go straight
+     * to or from buf. Return the status, same as endTransmission().
+     */
+    uint8_t readRegisters(uint8_t address, uint16_t reg, uint8_t regSize,
+                          uint8_t *buf, size_t len);
+    uint8_t writeRegisters(uint8_t address, uint16_t reg, uint8_t regSize,
+                           const uint8_t *buf, size_t len);
+
+    /* Asynchronous master transfers: the callback is called from the
+     * interrupt at the end of the transfer, with the endTransmission()
+     * status. Buffers are in use until then, which can be checked with
+     * isBusy() or waited with waitForCompletion().
+     * Return false if the transfer is not started.
+     */
+    bool endTransmissionAsync(cb_function_async_t callback = nullptr, bool sendStop = true);
+    // Received data are available() at the end of the transfer
+    bool requestFromAsync(uint8_t address, uint16_t quantity,
+                          cb_function_async_t callback = nullptr, bool sendStop = true);
+    bool isBusy(void)
+    {
+      return _i2c.async_busy;
+    };
+    // Status of the last asynchronous transfer, same as endTransmission()
+    uint8_t waitForCompletion(void);
+
     virtual size_t write(uint8_t);
     virtual size_t write(const uint8_t *, size_t);
     virtual int available(void);
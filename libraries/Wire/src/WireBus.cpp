@@ -0,0 +1,271 @@
+/*
+ * I2C bus manager for arduino.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include "WireBus.h"
+
+/**
+  * @brief  Bus manager of a TwoWire instance.
+  * @param  wire: TwoWire instance, begin() must be called before queuing.
+  */
+WireBus::WireBus(TwoWire &wire)
+  : _wire(wire)
+{
+}
+
+/**
+  * @brief  Queue a register read, started at once if the bus is idle.
+  * @param  address: 7-bit address of the device.
+  * @param  reg: register address.
+  * @param  reg_size: register address size in bytes: 1 or 2, 0 without.
+  * @param  rx_buf: array of Rx bytes.
+  * @param  count: number of bytes to read.
+  * @param  callback: function called at the end of the transaction (optional).
+  * @param  arg: argument given to the callback.
+  * @param  repeatedStart: false to end the register write with a stop.
+  * @return true if queued, false if the queue is full or nothing is to read.
+  */
+bool WireBus::queueRead(uint8_t address, uint16_t reg, uint8_t reg_size, void *rx_buf,
+                        size_t count, WireBusCallback callback, void *arg, bool repeatedStart)
+{
+  Transaction transaction;
+
+  if ((rx_buf == NULL) || (count == 0) || (count > UINT16_MAX)) {
+    return false;
+  }
+  transaction.address = address;
+  transaction.read = true;
+  transaction.repeatedStart = repeatedStart;
+  transaction.regSize = reg_size;
+  transaction.reg = reg;
+  transaction.count = count;
+  transaction.buf = rx_buf;
+  transaction.callback = callback;
+  transaction.arg = arg;
+  return queueTransaction(transaction);
+}
+
+/**
+  * @brief  Queue a register write, started at once if the bus is idle.
+  * @param  address: 7-bit address of the device.
+  * @param  reg: register address.
+  * @param  reg_size: register address size in bytes: 1 or 2, 0 without.
+  * @param  tx_buf: array of Tx bytes. Can be NULL to only send the register
+  *                 address.
+  * @param  count: number of bytes to write.
+  * @param  callback: function called at the end of the transaction (optional).
+  * @param  arg: argument given to the callback.
+  * @return true if queued, false if the queue is full or nothing is to send.
+  */
+bool WireBus::queueWrite(uint8_t address, uint16_t reg, uint8_t reg_size, const void *tx_buf,
+                         size_t count, WireBusCallback callback, void *arg)
+{
+  Transaction transaction;
+
+  if (tx_buf == NULL) {
+    count = 0;
+  }
+  if (((reg_size == 0) && (count == 0)) || (count > UINT16_MAX)) {
+    return false;
+  }
+  transaction.address = address;
+  transaction.read = false;
+  transaction.repeatedStart = false;
+  transaction.regSize = reg_size;
+  transaction.reg = reg;
+  transaction.count = count;
+  transaction.buf = (void *)tx_buf;
+  transaction.callback = callback;
+  transaction.arg = arg;
+  return queueTransaction(transaction);
+}
+
+/**
+  * @brief  Copy a transaction in the queue. Its register address is also
+  *         split in bytes, most significant first, for the transfers which
+  *         send it alone. The I2C is started if no transaction is running.
+  * @param  transaction: transaction to queue.
+  * @return true if queued, false if the queue is full or the register
+  *         address size is not supported.
+  */
+bool WireBus::queueTransaction(const Transaction &transaction)
+{
+  uint32_t primask;
+  uint16_t next;
+  bool idle;
+
+  if (transaction.regSize > 2) {
+    return false;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  next = (_head + 1) % (WIRE_BUS_QUEUE_SIZE + 1);
+  if (next == _tail) {
+    __set_PRIMASK(primask);
+    return false;
+  }
+  _queue[_head] = transaction;
+  if (transaction.regSize == 2) {
+    _queue[_head].regBytes[0] = (uint8_t)(transaction.reg >> 8);
+    _queue[_head].regBytes[1] = (uint8_t)transaction.reg;
+  } else {
+    _queue[_head].regBytes[0] = (uint8_t)transaction.reg;
+  }
+  _head = next;
+  idle = !_active;
+  _active = true;
+  __set_PRIMASK(primask);
+
+  if (idle) {
+    start();
+  }
+  return true;
+}
+
+/**
+  * @brief  Number of transactions not ended yet, the one on the bus included.
+  *         A transfer stalled for I2C_TIMEOUT_TICK is ended with a timeout.
+  */
+size_t WireBus::pending(void)
+{
+  i2c_master_poll(&(_wire._i2c));
+  uint16_t head = _head;
+  uint16_t tail = _tail;
+
+  return (head >= tail) ? (head - tail) : (WIRE_BUS_QUEUE_SIZE + 1 + head - tail);
+}
+
+/**
+  * @brief  Wait until the I2C interrupt has ended the last queued transaction.
+  *         A transfer which does not end (e.g. SCL held low by a device) is
+  *         aborted after I2C_TIMEOUT_TICK, its transaction ends with a
+  *         timeout status and the next one is started.
+  */
+void WireBus::flush(void)
+{
+  while (_active) {
+    i2c_master_poll(&(_wire._i2c));
+  }
+}
+
+/**
+  * @brief  Check if all the queued transactions have ended.
+  *         A transfer stalled for I2C_TIMEOUT_TICK is ended with a timeout.
+  */
+bool WireBus::isIdle(void)
+{
+  i2c_master_poll(&(_wire._i2c));
+  return !_active;
+}
+
+/**
+  * @brief  Start a transfer without register address, ended with a stop.
+  * @param  data: array of bytes to send or receive.
+  * @param  size: number of bytes.
+  * @param  read: true to receive, false to send.
+  * @return I2C_OK if started.
+  */
+i2c_status_e WireBus::transfer(uint8_t *data, uint16_t size, bool read)
+{
+  i2c_t *obj = &(_wire._i2c);
+  uint8_t address = _queue[_tail].address << 1;
+
+#if defined(I2C_OTHER_FRAME)
+  obj->handle.XferOptions = I2C_OTHER_AND_LAST_FRAME;
+#endif
+  if (read) {
+    return i2c_master_read_async(obj, address, data, size, complete, this);
+  }
+  return i2c_master_write_async(obj, address, data, size, complete, this);
+}
+
+/**
+  * @brief  Start the transaction at the queue tail. The register address
+  *         and the data are a single transfer, except for a read without
+  *         repeated start where the register address is sent first.
+  */
+void WireBus::start(void)
+{
+  Transaction *transaction = &_queue[_tail];
+  i2c_t *obj = &(_wire._i2c);
+  uint8_t address = transaction->address << 1;
+  i2c_status_e ret;
+
+  _dataPhase = true;
+  if (transaction->regSize == 0) {
+    ret = transfer((uint8_t *)transaction->buf, transaction->count, transaction->read);
+  } else if (transaction->count == 0) {
+    ret = transfer(transaction->regBytes, transaction->regSize, false);
+  } else if (!transaction->read) {
+    ret = i2c_master_mem_write_async(obj, address, transaction->reg, transaction->regSize,
+                                     (uint8_t *)transaction->buf, transaction->count,
+                                     complete, this);
+  } else if (transaction->repeatedStart) {
+    ret = i2c_master_mem_read_async(obj, address, transaction->reg, transaction->regSize,
+                                    (uint8_t *)transaction->buf, transaction->count,
+                                    complete, this);
+  } else {
+    _dataPhase = false;
+    ret = transfer(transaction->regBytes, transaction->regSize, false);
+  }
+  if (ret != I2C_OK) {
+    finish(TwoWire::statusCode(ret));
+  }
+}
+
+/**
+  * @brief  End the transaction at the queue tail, its STOP condition is
+  *         sent. The START of the next one is issued before calling the
+  *         callback, which then runs while the next device is addressed.
+  * @param  status: status of the transaction, same as endTransmission().
+  */
+void WireBus::finish(uint8_t status)
+{
+  /* Copied: once the tail moves, a transaction queued by the callback can
+   * overwrite the slot */
+  Transaction transaction = _queue[_tail];
+  uint32_t primask;
+  bool more;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  _tail = (_tail + 1) % (WIRE_BUS_QUEUE_SIZE + 1);
+  more = (_tail != _head);
+  _active = more;
+  __set_PRIMASK(primask);
+
+  if (more) {
+    start();
+  }
+  if (transaction.callback != NULL) {
+    transaction.callback(transaction.arg, status);
+  }
+}
+
+/**
+  * @brief  End of an asynchronous transfer. A read without repeated start
+  *         has sent its register address followed by a STOP: the data are
+  *         then read in a second transfer. Otherwise the transaction is done.
+  * @param  arg: WireBus instance.
+  */
+void WireBus::complete(void *arg)
+{
+  WireBus *bus = (WireBus *)arg;
+  Transaction *transaction = &bus->_queue[bus->_tail];
+  i2c_status_e ret = i2c_master_wait(&(bus->_wire._i2c));
+
+  if ((ret == I2C_OK) && !bus->_dataPhase) {
+    bus->_dataPhase = true;
+    ret = bus->transfer((uint8_t *)transaction->buf, transaction->count, true);
+    if (ret == I2C_OK) {
+      return;
+    }
+  }
+  bus->finish(TwoWire::statusCode(ret));
+}
@@ -0,0 +1,85 @@
+/*
+ * I2C bus manager for arduino.
+ * Queues register reads and writes to the devices of a TwoWire instance and
+ * runs them back to back from the I2C interrupt.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _WIREBUS_H_INCLUDED
+#define _WIREBUS_H_INCLUDED
+
+#include "Wire.h"
+
+// Defines the number of transactions which can be queued on a bus
+#ifndef WIRE_BUS_QUEUE_SIZE
+#define WIRE_BUS_QUEUE_SIZE 8
+#elif (WIRE_BUS_QUEUE_SIZE <= 0) || (WIRE_BUS_QUEUE_SIZE >= 65535)
+#error "WIRE_BUS_QUEUE_SIZE must be between 1 and 65534!"
+#endif
+
+// Function called at the end of a transaction, status is the one of
+// endTransmission(): 0 on success
+typedef void (*WireBusCallback)(void *arg, uint8_t status);
+
+class WireBus {
+  public:
+    WireBus(TwoWire &wire = Wire);
+
+    /* Queue a register access: the transfers are chained from the I2C (or
+     * DMA) interrupt, which also calls the callback. Buffers must be kept
+     * until the callback or flush(). Wire must not be used directly until
+     * isIdle() returns true.
+     * reg_size is the size in bytes of the register address (1 or 2, most
+     * significant byte first), sent before the data, 0 without register.
+     */
+    // Read count bytes after the register address, with a repeated start,
+    // or with a stop and a start when repeatedStart is false
+    bool queueRead(uint8_t address, uint16_t reg, uint8_t reg_size, void *rx_buf, size_t count,
+                   WireBusCallback callback = NULL, void *arg = NULL, bool repeatedStart = true);
+    // Write count bytes after the register address, in a single transfer
+    bool queueWrite(uint8_t address, uint16_t reg, uint8_t reg_size, const void *tx_buf,
+                    size_t count, WireBusCallback callback = NULL, void *arg = NULL);
+
+    // Number of transactions not ended yet, the one on the bus included
+    size_t pending(void);
+    bool isIdle(void);
+    // Wait until the last queued transaction has ended
+    void flush(void);
+
+  private:
+    struct Transaction {
+      uint8_t         address;
+      bool            read;
+      bool            repeatedStart;
+      uint8_t         regSize;
+      uint16_t        reg;
+      /* Register address sent alone, most significant byte first */
+      uint8_t         regBytes[2];
+      uint16_t        count;
+      void           *buf;
+      WireBusCallback callback;
+      void           *arg;
+    };
+
+    TwoWire          &_wire;
+    /* Ring of transactions, one slot is kept free so head == tail is empty */
+    Transaction       _queue[WIRE_BUS_QUEUE_SIZE + 1];
+    volatile uint16_t _head = 0;
+    volatile uint16_t _tail = 0;
+    volatile bool     _active = false;
+    /* False while the register address of a read without repeated start
+     * is sent, before the data are read */
+    bool              _dataPhase = false;
+
+    bool queueTransaction(const Transaction &transaction);
+    void start(void);
+    void finish(uint8_t status);
+    i2c_status_e transfer(uint8_t *data, uint16_t size, bool read);
+    static void complete(void *arg);
+};
+
+#endif /* _WIREBUS_H_INCLUDED */
@@ -184,6 +184,10 @@ typedef enum {
 /* Private Variables */
 static I2C_HandleTypeDef *i2c_handles[I2C_NUM];
 
+/* Private Functions */
+static void i2c_register_callbacks(i2c_t *obj);
+i2c_t *get_i2c_obj(I2C_HandleTypeDef *hi2c);
+
 #ifdef I2C_TIMING_COMPUTE
 /**
   * @brief  This function return the I2C clock source frequency.
@@ -790,6 +794,7 @@ void i2c_custom_init(i2c_t *obj, uint32_t timing, uint32_t addressingMode, uint3
           /* Initialization Error */
           Error_Handler();
         }
+        i2c_register_callbacks(obj);
 
         /* Initialize default values */
         obj->slaveRxNbData = 0;
@@ -806,11 +811,23 @@ void i2c_custom_init(i2c_t *obj, uint32_t timing, uint32_t addressingMode, uint3
   */
 void i2c_deinit(i2c_t *obj)
 {
+  i2c_master_wait(obj);
   HAL_NVIC_DisableIRQ(obj->irq);
 #if !defined(STM32C0xx) && !defined(STM32F0xx) && !defined(STM32G0xx) && !defined(STM32L0xx)
   HAL_NVIC_DisableIRQ(obj->irqER);
 #endif /* !STM32C0xx && !STM32F0xx && !STM32G0xx && !STM32L0xx */
   HAL_I2C_DeInit(&(obj->handle));
+#if defined(I2C_DMA_ENABLED)
+  if (obj->dma_ready & I2C_DMA_TX) {
+    dma_deinit(&(obj->hdma_tx));
+  }
+  if (obj->dma_ready & I2C_DMA_RX) {
+    dma_deinit(&(obj->hdma_rx));
+  }
+  obj->dma_ready = 0;
+  obj->handle.hdmatx = NULL;
+  obj->handle.hdmarx = NULL;
+#endif
   /* Reset I2C GPIO pins as INPUT_ANALOG */
   pin_function(obj->scl, STM_PIN_DATA(STM_MODE_ANALOG, GPIO_NOPULL, 0));
   pin_function(obj->sda, STM_PIN_DATA(STM_MODE_ANALOG, GPIO_NOPULL, 0));
@@ -886,6 +903,26 @@ void i2c_setTiming(i2c_t *obj, uint32_t frequency)
   __HAL_I2C_ENABLE(&(obj->handle));
 }
 
+/**
+  * @brief  Status of the last master transfer from the HAL error code
+  * @param  obj : pointer to i2c_t structure
+  * @retval status
+  */
+static i2c_status_e i2c_error_status(i2c_t *obj)
+{
+  uint32_t err = HAL_I2C_GetError(&(obj->handle));
+  i2c_status_e ret = I2C_OK;
+
+  if ((err & HAL_I2C_ERROR_TIMEOUT) == HAL_I2C_ERROR_TIMEOUT) {
+    ret = I2C_TIMEOUT;
+  } else if ((err & HAL_I2C_ERROR_AF) == HAL_I2C_ERROR_AF) {
+    ret = I2C_NACK_DATA;
+  } else if (err != HAL_I2C_ERROR_NONE) {
+    ret = I2C_ERROR;
+  }
+  return ret;
+}
+
 /**
   * @brief  Write bytes at a given address
   * @param  obj : pointer to i2c_t structure
@@ -901,7 +938,6 @@ i2c_status_e i2c_master_write(i2c_t *obj, uint8_t dev_address,
   i2c_status_e ret = I2C_OK;
   uint32_t tickstart = HAL_GetTick();
   uint32_t delta = 0;
-  uint32_t err = 0;
   HAL_StatusTypeDef status = HAL_OK;
 
   /* When size is 0, this is usually an I2C scan / ping to check if device is there and ready */
@@ -939,17 +975,7 @@ i2c_status_e i2c_master_write(i2c_t *obj, uint8_t dev_address,
         }
       }
 
-      err = HAL_I2C_GetError(&(obj->handle));
-      if ((delta >= I2C_TIMEOUT_TICK)
-          || ((err & HAL_I2C_ERROR_TIMEOUT) == HAL_I2C_ERROR_TIMEOUT)) {
-        ret = I2C_TIMEOUT;
-      } else {
-        if ((err & HAL_I2C_ERROR_AF) == HAL_I2C_ERROR_AF) {
-          ret = I2C_NACK_DATA;
-        } else if (err != HAL_I2C_ERROR_NONE) {
-          ret = I2C_ERROR;
-        }
-      }
+      ret = (delta >= I2C_TIMEOUT_TICK) ? I2C_TIMEOUT : i2c_error_status(obj);
     }
   }
   return ret;
@@ -994,7 +1020,6 @@ i2c_status_e i2c_master_read(i2c_t *obj, uint8_t dev_address, uint8_t *data, uin
   i2c_status_e ret = I2C_OK;
   uint32_t tickstart = HAL_GetTick();
   uint32_t delta = 0;
-  uint32_t err = 0;
   HAL_StatusTypeDef status = HAL_OK;
 
 #if defined(I2C_OTHER_FRAME)
@@ -1028,21 +1053,455 @@ i2c_status_e i2c_master_read(i2c_t *obj, uint8_t dev_address, uint8_t *data, uin
       }
     }
 
-    err = HAL_I2C_GetError(&(obj->handle));
-    if ((delta >= I2C_TIMEOUT_TICK)
-        || ((err & HAL_I2C_ERROR_TIMEOUT) == HAL_I2C_ERROR_TIMEOUT)) {
-      ret = I2C_TIMEOUT;
-    } else {
-      if ((err & HAL_I2C_ERROR_AF) == HAL_I2C_ERROR_AF) {
-        ret = I2C_NACK_DATA;
-      } else if (err != HAL_I2C_ERROR_NONE) {
-        ret = I2C_ERROR;
+    ret = (delta >= I2C_TIMEOUT_TICK) ? I2C_TIMEOUT : i2c_error_status(obj);
+  }
+  return ret;
+}
+
+/**
+  * @brief  End of an asynchronous master transfer
+  * @note   Called from the I2C (or DMA) interrupt, or from i2c_master_wait()
+  *         on timeout: the first caller completes the transfer.
+  * @param  obj : pointer to i2c_t structure
+  * @param  status : status of the transfer
+  * @retval None
+  */
+static void i2c_async_complete(i2c_t *obj, i2c_status_e status)
+{
+  void (*callback)(void *arg) = obj->async_callback;
+  uint32_t primask = __get_PRIMASK();
+  uint8_t busy;
+
+  __disable_irq();
+  busy = obj->async_busy;
+  if (busy) {
+    obj->async_status = status;
+    obj->async_busy = 0;
+  }
+  __set_PRIMASK(primask);
+
+  if (busy) {
+#if defined(I2C_DMA_ENABLED)
+    if (obj->dma_rx_buffer != NULL) {
+      dma_invalidate_dcache(obj->dma_rx_buffer, obj->dma_len);
+      obj->dma_rx_buffer = NULL;
+    }
+#endif
+    if (callback != NULL) {
+      callback(obj->async_arg);
+    }
+  }
+}
+
+/**
+  * @brief  Master transfer complete callback, ends an asynchronous transfer
+  * @param  hi2c Pointer to a I2C_HandleTypeDef structure that contains
+  *                the configuration information for the specified I2C.
+  * @retval None
+  */
+static void i2c_master_cplt(I2C_HandleTypeDef *hi2c)
+{
+  i2c_async_complete(get_i2c_obj(hi2c), I2C_OK);
+}
+
+/**
+  * @brief  Register the master complete callbacks in the handle when the HAL
+  *         callbacks registration is enabled: HAL_I2C_MasterTxCpltCallback(),
+  *         HAL_I2C_MasterRxCpltCallback(), HAL_I2C_MemTxCpltCallback() and
+  *         HAL_I2C_MemRxCpltCallback() are then free for the application.
+  *         Else those functions are defined by this driver.
+  * @note   HAL_I2C_Init() resets the registered callbacks from the reset state
+  * @param  obj : pointer to i2c_t structure
+  * @retval None
+  */
+static void i2c_register_callbacks(i2c_t *obj)
+{
+#if defined(USE_HAL_I2C_REGISTER_CALLBACKS) && (USE_HAL_I2C_REGISTER_CALLBACKS == 1U)
+  HAL_I2C_RegisterCallback(&(obj->handle), HAL_I2C_MASTER_TX_COMPLETE_CB_ID, i2c_master_cplt);
+  HAL_I2C_RegisterCallback(&(obj->handle), HAL_I2C_MASTER_RX_COMPLETE_CB_ID, i2c_master_cplt);
+  HAL_I2C_RegisterCallback(&(obj->handle), HAL_I2C_MEM_TX_COMPLETE_CB_ID, i2c_master_cplt);
+  HAL_I2C_RegisterCallback(&(obj->handle), HAL_I2C_MEM_RX_COMPLETE_CB_ID, i2c_master_cplt);
+#else
+  UNUSED(obj);
+#endif
+}
+
+/**
+  * @brief  Abort a running asynchronous master transfer: the DMA channels are
+  *         stopped and the I2C is reinitialized, so that the handle is ready
+  *         and the data buffer is no more accessed.
+  * @note   The I2C interrupts must be disabled by the caller.
+  * @param  obj : pointer to i2c_t structure
+  * @retval None
+  */
+static void i2c_master_abort(i2c_t *obj)
+{
+#if defined(I2C_DMA_ENABLED)
+  if ((obj->dma_ready & I2C_DMA_TX) && (HAL_DMA_GetState(&(obj->hdma_tx)) == HAL_DMA_STATE_BUSY)) {
+    HAL_DMA_Abort(&(obj->hdma_tx));
+  }
+  if ((obj->dma_ready & I2C_DMA_RX) && (HAL_DMA_GetState(&(obj->hdma_rx)) == HAL_DMA_STATE_BUSY)) {
+    HAL_DMA_Abort(&(obj->hdma_rx));
+  }
+#endif
+  /* Same as the bus recovery: the peripheral reset releases the lines */
+  HAL_I2C_DeInit(&(obj->handle));
+  if (HAL_I2C_Init(&(obj->handle)) == HAL_OK) {
+    i2c_register_callbacks(obj);
+    __HAL_I2C_ENABLE(&(obj->handle));
+  }
+}
+
+/**
+  * @brief  Start a master transfer with the DMA if available, else with
+  *         interrupts
+  * @param  obj : pointer to i2c_t structure
+  * @param  dev_address: specifies the address of the device.
+  * @param  mem_address: register address sent first, in a single transfer
+  * @param  mem_size: register address size in bytes (1 or 2), 0 without
+  * @param  data: pointer to data to be sent or received
+  * @param  size: number of bytes to be sent or received.
+  * @param  options: XferOptions of the sequential transfers
+  * @param  read: true to receive, false to send
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef i2c_master_start(i2c_t *obj, uint8_t dev_address,
+                                          uint16_t mem_address, uint8_t mem_size,
+                                          uint8_t *data, uint16_t size,
+                                          uint32_t options, bool read)
+{
+  I2C_HandleTypeDef *handle = &(obj->handle);
+  uint16_t mem_add_size = (mem_size == 2) ? I2C_MEMADD_SIZE_16BIT : I2C_MEMADD_SIZE_8BIT;
+
+#if !defined(I2C_OTHER_FRAME)
+  UNUSED(options);
+#endif
+#if defined(I2C_DMA_ENABLED)
+  obj->dma_rx_buffer = NULL;
+  if ((obj->dma_threshold != 0) && (size >= obj->dma_threshold) &&
+      (obj->dma_ready & (read ? I2C_DMA_RX : I2C_DMA_TX))) {
+    if (read) {
+      obj->dma_rx_buffer = data;
+      obj->dma_len = size;
+      if (mem_size != 0) {
+        return HAL_I2C_Mem_Read_DMA(handle, dev_address, mem_address, mem_add_size, data, size);
       }
+#if defined(I2C_OTHER_FRAME)
+      return HAL_I2C_Master_Seq_Receive_DMA(handle, dev_address, data, size, options);
+#else
+      return HAL_I2C_Master_Receive_DMA(handle, dev_address, data, size);
+#endif
+    }
+    dma_clean_dcache(data, size);
+    if (mem_size != 0) {
+      return HAL_I2C_Mem_Write_DMA(handle, dev_address, mem_address, mem_add_size, data, size);
+    }
+#if defined(I2C_OTHER_FRAME)
+    return HAL_I2C_Master_Seq_Transmit_DMA(handle, dev_address, data, size, options);
+#else
+    return HAL_I2C_Master_Transmit_DMA(handle, dev_address, data, size);
+#endif
+  }
+#endif /* I2C_DMA_ENABLED */
+  if (read) {
+    if (mem_size != 0) {
+      return HAL_I2C_Mem_Read_IT(handle, dev_address, mem_address, mem_add_size, data, size);
+    }
+#if defined(I2C_OTHER_FRAME)
+    return HAL_I2C_Master_Seq_Receive_IT(handle, dev_address, data, size, options);
+#else
+    return HAL_I2C_Master_Receive_IT(handle, dev_address, data, size);
+#endif
+  }
+  if (mem_size != 0) {
+    return HAL_I2C_Mem_Write_IT(handle, dev_address, mem_address, mem_add_size, data, size);
+  }
+#if defined(I2C_OTHER_FRAME)
+  return HAL_I2C_Master_Seq_Transmit_IT(handle, dev_address, data, size, options);
+#else
+  return HAL_I2C_Master_Transmit_IT(handle, dev_address, data, size);
+#endif
+}
+
+/**
+  * @brief  Start an asynchronous master transfer
+  * @param  obj : pointer to i2c_t structure
+  * @param  dev_address: specifies the address of the device.
+  * @param  mem_address: register address sent first, in a single transfer
+  * @param  mem_size: register address size in bytes (1 or 2), 0 without
+  * @param  data: pointer to data to be sent or received
+  * @param  size: number of bytes to be sent or received.
+  * @param  callback: function called at the end of the transfer, can be NULL
+  * @param  arg: argument given to the callback
+  * @param  read: true to receive, false to send
+  * @retval I2C_OK if the transfer is started, else the callback is not called
+  */
+static i2c_status_e i2c_master_async(i2c_t *obj, uint8_t dev_address,
+                                     uint16_t mem_address, uint8_t mem_size,
+                                     uint8_t *data, uint16_t size,
+                                     void (*callback)(void *arg), void *arg, bool read)
+{
+  i2c_status_e ret = I2C_OK;
+  uint32_t tickstart = HAL_GetTick();
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t XferOptions = 0;
+
+  if ((obj == NULL) || obj->async_busy) {
+    return I2C_BUSY;
+  }
+  if ((mem_size > 2) || ((mem_size != 0) && ((data == NULL) || (size == 0)))) {
+    return I2C_ERROR;
+  }
+#if defined(I2C_OTHER_FRAME)
+  XferOptions = obj->handle.XferOptions; // save XferOptions value, because handle can be modified by HAL, which cause issue in case of NACK from slave
+#endif
+  obj->async_callback = callback;
+  obj->async_arg = arg;
+  obj->async_status = I2C_OK;
+  /* Set first: the transfer can end before the HAL function returns */
+  obj->async_busy = 1;
+
+  if (size == 0) {
+    /* I2C scan / ping: nothing to wait for */
+    i2c_async_complete(obj, read ? I2C_ERROR : i2c_IsDeviceReady(obj, dev_address, 1));
+    return I2C_OK;
+  }
+  do {
+    obj->async_tick = HAL_GetTick();
+    status = i2c_master_start(obj, dev_address, mem_address, mem_size, data, size,
+                              XferOptions, read);
+    // Ensure i2c ready
+    if ((status == HAL_BUSY) && ((HAL_GetTick() - tickstart) > I2C_TIMEOUT_TICK)) {
+      break;
     }
+  } while (status == HAL_BUSY);
+
+  if (status != HAL_OK) {
+    ret = (status == HAL_BUSY) ? I2C_BUSY : I2C_ERROR;
+    obj->async_busy = 0;
+  }
+  return ret;
+}
+
+/**
+  * @brief  Write bytes at a given address without waiting for the end of
+  *         the transfer
+  * @note   Data are sent with interrupts, or with the DMA when enabled.
+  *         They must be kept until the end of the transfer.
+  * @param  obj : pointer to i2c_t structure
+  * @param  dev_address: specifies the address of the device.
+  * @param  data: pointer to data to be write
+  * @param  size: number of bytes to be write, 0 to check the device
+  * @param  callback: function called at the end of the transfer, can be NULL
+  * @param  arg: argument given to the callback
+  * @retval I2C_OK if the transfer is started, I2C_BUSY or I2C_ERROR else
+  */
+i2c_status_e i2c_master_write_async(i2c_t *obj, uint8_t dev_address, uint8_t *data,
+                                    uint16_t size, void (*callback)(void *arg), void *arg)
+{
+  return i2c_master_async(obj, dev_address, 0, 0, data, size, callback, arg, false);
+}
+
+/**
+  * @brief  Read bytes in master mode at a given address without waiting for
+  *         the end of the transfer
+  * @note   Data are received with interrupts, or with the DMA when enabled.
+  * @param  obj : pointer to i2c_t structure
+  * @param  dev_address: specifies the address of the device.
+  * @param  data: pointer to data to be read
+  * @param  size: number of bytes to be read.
+  * @param  callback: function called at the end of the transfer, can be NULL
+  * @param  arg: argument given to the callback
+  * @retval I2C_OK if the transfer is started, I2C_BUSY or I2C_ERROR else
+  */
+i2c_status_e i2c_master_read_async(i2c_t *obj, uint8_t dev_address, uint8_t *data,
+                                   uint16_t size, void (*callback)(void *arg), void *arg)
+{
+  return i2c_master_async(obj, dev_address, 0, 0, data, size, callback, arg, true);
+}
+
+/**
+  * @brief  Write bytes to the register of a device without waiting for the
+  *         end of the transfer
+  * @note   The register address and the data are sent in a single transfer.
+  *         Data must be kept until the end of the transfer.
+  * @param  obj : pointer to i2c_t structure
+  * @param  dev_address: specifies the address of the device.
+  * @param  mem_address: register address, most significant byte first
+  * @param  mem_size: register address size in bytes: 1 or 2
+  * @param  data: pointer to data to be write
+  * @param  size: number of bytes to be write, at least 1
+  * @param  callback: function called at the end of the transfer, can be NULL
+  * @param  arg: argument given to the callback
+  * @retval I2C_OK if the transfer is started, I2C_BUSY or I2C_ERROR else
+  */
+i2c_status_e i2c_master_mem_write_async(i2c_t *obj, uint8_t dev_address,
+                                        uint16_t mem_address, uint8_t mem_size,
+                                        uint8_t *data, uint16_t size,
+                                        void (*callback)(void *arg), void *arg)
+{
+  if (mem_size == 0) {
+    return I2C_ERROR;
+  }
+  return i2c_master_async(obj, dev_address, mem_address, mem_size, data, size,
+                          callback, arg, false);
+}
+
+/**
+  * @brief  Read bytes from the register of a device without waiting for the
+  *         end of the transfer
+  * @note   The register address is sent, then the data are read after a
+  *         repeated start.
+  * @param  obj : pointer to i2c_t structure
+  * @param  dev_address: specifies the address of the device.
+  * @param  mem_address: register address, most significant byte first
+  * @param  mem_size: register address size in bytes: 1 or 2
+  * @param  data: pointer to data to be read
+  * @param  size: number of bytes to be read, at least 1
+  * @param  callback: function called at the end of the transfer, can be NULL
+  * @param  arg: argument given to the callback
+  * @retval I2C_OK if the transfer is started, I2C_BUSY or I2C_ERROR else
+  */
+i2c_status_e i2c_master_mem_read_async(i2c_t *obj, uint8_t dev_address,
+                                       uint16_t mem_address, uint8_t mem_size,
+                                       uint8_t *data, uint16_t size,
+                                       void (*callback)(void *arg), void *arg)
+{
+  if (mem_size == 0) {
+    return I2C_ERROR;
+  }
+  return i2c_master_async(obj, dev_address, mem_address, mem_size, data, size,
+                          callback, arg, true);
+}
+
+/**
+  * @brief  Write bytes to the register of a device
+  * @note   The register address and the data are sent in a single transfer.
+  * @param  obj : pointer to i2c_t structure
+  * @param  dev_address: specifies the address of the device.
+  * @param  mem_address: register address, most significant byte first
+  * @param  mem_size: register address size in bytes: 1 or 2
+  * @param  data: pointer to data to be write
+  * @param  size: number of bytes to be write, at least 1
+  * @retval write status
+  */
+i2c_status_e i2c_master_mem_write(i2c_t *obj, uint8_t dev_address,
+                                  uint16_t mem_address, uint8_t mem_size,
+                                  uint8_t *data, uint16_t size)
+{
+  i2c_status_e ret;
+
+  // wait for the end of a previous asynchronous transfer
+  i2c_master_wait(obj);
+  ret = i2c_master_mem_write_async(obj, dev_address, mem_address, mem_size, data, size,
+                                   NULL, NULL);
+  if (ret == I2C_OK) {
+    ret = i2c_master_wait(obj);
   }
   return ret;
 }
 
+/**
+  * @brief  Read bytes from the register of a device
+  * @note   The register address is sent, then the data are read after a
+  *         repeated start.
+  * @param  obj : pointer to i2c_t structure
+  * @param  dev_address: specifies the address of the device.
+  * @param  mem_address: register address, most significant byte first
+  * @param  mem_size: register address size in bytes: 1 or 2
+  * @param  data: pointer to data to be read
+  * @param  size: number of bytes to be read, at least 1
+  * @retval read status
+  */
+i2c_status_e i2c_master_mem_read(i2c_t *obj, uint8_t dev_address,
+                                 uint16_t mem_address, uint8_t mem_size,
+                                 uint8_t *data, uint16_t size)
+{
+  i2c_status_e ret;
+
+  // wait for the end of a previous asynchronous transfer
+  i2c_master_wait(obj);
+  ret = i2c_master_mem_read_async(obj, dev_address, mem_address, mem_size, data, size,
+                                  NULL, NULL);
+  if (ret == I2C_OK) {
+    ret = i2c_master_wait(obj);
+  }
+  return ret;
+}
+
+/**
+  * @brief  Check the asynchronous master transfer without waiting: it is
+  *         aborted and completed with I2C_TIMEOUT when it has not ended
+  *         within I2C_TIMEOUT_TICK from its start.
+  * @param  obj : pointer to i2c_t structure
+  * @retval true while the transfer is running
+  */
+bool i2c_master_poll(i2c_t *obj)
+{
+  if (!obj->async_busy) {
+    return false;
+  }
+  if ((HAL_GetTick() - obj->async_tick) >= I2C_TIMEOUT_TICK) {
+    /* Stop the transfer before completing it, else the handle stays busy
+     * and a late end could still write into the caller buffer */
+    HAL_NVIC_DisableIRQ(obj->irq);
+#if !defined(STM32C0xx) && !defined(STM32F0xx) && !defined(STM32G0xx) && !defined(STM32L0xx)
+    HAL_NVIC_DisableIRQ(obj->irqER);
+#endif /* !STM32C0xx && !STM32F0xx && !STM32G0xx && !STM32L0xx */
+    if (obj->async_busy) {
+      i2c_master_abort(obj);
+    }
+    HAL_NVIC_EnableIRQ(obj->irq);
+#if !defined(STM32C0xx) && !defined(STM32F0xx) && !defined(STM32G0xx) && !defined(STM32L0xx)
+    HAL_NVIC_EnableIRQ(obj->irqER);
+#endif /* !STM32C0xx && !STM32F0xx && !STM32G0xx && !STM32L0xx */
+    i2c_async_complete(obj, I2C_TIMEOUT);
+  }
+  return obj->async_busy;
+}
+
+/**
+  * @brief  Wait for the end of the asynchronous master transfer
+  * @note   Can be called from the callback to get the transfer status.
+  *         The transfer is completed with I2C_TIMEOUT when it does not end
+  *         within I2C_TIMEOUT_TICK.
+  * @param  obj : pointer to i2c_t structure
+  * @retval status of the last asynchronous transfer
+  */
+i2c_status_e i2c_master_wait(i2c_t *obj)
+{
+  while (i2c_master_poll(obj));
+  return (i2c_status_e)obj->async_status;
+}
+
+#if defined(I2C_DMA_ENABLED)
+/**
+  * @brief  Initialize the DMA channels requested for the master transfers
+  * @param  obj : pointer to i2c_t structure
+  * @retval None
+  */
+void i2c_attach_dma(i2c_t *obj)
+{
+  if (obj == NULL) {
+    return;
+  }
+  obj->dma_ready = 0;
+  /* Callbacks are set by the HAL for each transfer */
+  if ((obj->dma_tx != NULL) &&
+      dma_init(&(obj->hdma_tx), obj->dma_tx, obj->dma_tx_request,
+               DMA_MEMORY_TO_PERIPH, DMA_NORMAL, 1)) {
+    __HAL_LINKDMA(&(obj->handle), hdmatx, obj->hdma_tx);
+    obj->dma_ready |= I2C_DMA_TX;
+  }
+  if ((obj->dma_rx != NULL) &&
+      dma_init(&(obj->hdma_rx), obj->dma_rx, obj->dma_rx_request,
+               DMA_PERIPH_TO_MEMORY, DMA_NORMAL, 1)) {
+    __HAL_LINKDMA(&(obj->handle), hdmarx, obj->hdma_rx);
+    obj->dma_ready |= I2C_DMA_RX;
+  }
+}
+#endif /* I2C_DMA_ENABLED */
+
 /**
   * @brief  Checks if target device is ready for communication
   * @param  obj : pointer to i2c_t structure
@@ -1203,10 +1662,57 @@ void HAL_I2C_SlaveTxCpltCallback(I2C_HandleTypeDef *hi2c)
   obj->i2cTxRxBufferSize = 0;
 }
 
+#if !defined(USE_HAL_I2C_REGISTER_CALLBACKS) || (USE_HAL_I2C_REGISTER_CALLBACKS == 0U)
+/**
+  * @brief  Master TX complete callback, ends an asynchronous transfer
+  * @param  hi2c Pointer to a I2C_HandleTypeDef structure that contains
+  *                the configuration information for the specified I2C.
+  * @retval None
+  */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2c_master_cplt(hi2c);
+}
+
+/**
+  * @brief  Master RX complete callback, ends an asynchronous transfer
+  * @param  hi2c Pointer to a I2C_HandleTypeDef structure that contains
+  *                the configuration information for the specified I2C.
+  * @retval None
+  */
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2c_master_cplt(hi2c);
+}
+
+/**
+  * @brief  Memory TX complete callback, ends an asynchronous transfer
+  * @param  hi2c Pointer to a I2C_HandleTypeDef structure that contains
+  *                the configuration information for the specified I2C.
+  * @retval None
+  */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2c_master_cplt(hi2c);
+}
+
+/**
+  * @brief  Memory RX complete callback, ends an asynchronous transfer
+  * @param  hi2c Pointer to a I2C_HandleTypeDef structure that contains
+  *                the configuration information for the specified I2C.
+  * @retval None
+  */
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  i2c_master_cplt(hi2c);
+}
+#endif /* !USE_HAL_I2C_REGISTER_CALLBACKS */
+
 /**
   * @brief  I2C error callback.
-  * @note   In master mode, the callback is not used because the error is reported
-  *         to the Arduino API from i2c_master_write() and i2c_master_read().
+  * @note   In master mode, the error of a blocking transfer is reported to
+  *         the Arduino API from i2c_master_write() and i2c_master_read(),
+  *         the one of an asynchronous transfer ends it.
   *         In slave mode, there is no mechanism in Arduino API to report an error
   *         so the error callback forces the slave to listen again.
   * @param  hi2c Pointer to a I2C_HandleTypeDef structure that contains
@@ -1219,6 +1725,8 @@ void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
 
   if (obj->isMaster == 0) {
     HAL_I2C_EnableListen_IT(hi2c);
+  } else {
+    i2c_async_complete(obj, i2c_error_status(obj));
   }
 }
 
@@ -43,6 +43,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32_def.h"
 #include "PeripheralPins.h"
+#include "dma.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -67,6 +68,22 @@ extern "C" {
 #error I2C buffer size cannot exceed 255
 #endif
 
+/* DMA not supported by this series: master transfers are interrupt driven */
+#if defined(I2C_DMA_ENABLED) && !defined(DMA_WRAPPER_ENABLED)
+#undef I2C_DMA_ENABLED
+#endif
+
+#if defined(I2C_DMA_ENABLED)
+/* Minimum size in bytes of the DMA master transfers, shorter ones are
+ * interrupt driven */
+#ifndef I2C_DMA_THRESHOLD
+#define I2C_DMA_THRESHOLD       16
+#endif
+
+#define I2C_DMA_TX  0x01
+#define I2C_DMA_RX  0x02
+#endif
+
 /* Redefinition of IRQ for C0/F0/G0/L0 families */
 #if defined(STM32C0xx) || defined(STM32F0xx) || defined(STM32G0xx) || defined(STM32L0xx)
 #if defined(I2C1_BASE)
@@ -123,6 +140,29 @@ struct i2c_s {
   uint8_t isMaster;
   uint8_t generalCall;
   uint8_t NoStretchMode;
+  /* Asynchronous master transfer */
+  volatile uint8_t async_busy;
+  volatile uint8_t async_status;
+  void (*async_callback)(void *arg);
+  void *async_arg;
+  /* HAL tick at the start of the transfer */
+  uint32_t async_tick;
+#if defined(I2C_DMA_ENABLED)
+  /* DMA channels requested, NULL for interrupt driven transfers */
+  dma_channel_t *dma_tx;
+  uint32_t dma_tx_request;
+  DMA_HandleTypeDef hdma_tx;
+  dma_channel_t *dma_rx;
+  uint32_t dma_rx_request;
+  DMA_HandleTypeDef hdma_rx;
+  /* Transfers of at least dma_threshold bytes use the DMA, 0 to disable */
+  uint16_t dma_threshold;
+  /* DMA channels initialized (I2C_DMA_TX, I2C_DMA_RX) */
+  uint8_t dma_ready;
+  /* Buffer of the on-going DMA reception, to invalidate the data cache */
+  uint8_t *dma_rx_buffer;
+  uint16_t dma_len;
+#endif
 };
 
 ///@brief I2C state
@@ -145,6 +185,29 @@ void i2c_setTiming(i2c_t *obj, uint32_t frequency);
 i2c_status_e i2c_master_write(i2c_t *obj, uint8_t dev_address, uint8_t *data, uint16_t size);
 i2c_status_e i2c_slave_write_IT(i2c_t *obj, uint8_t *data, uint16_t size);
 i2c_status_e i2c_master_read(i2c_t *obj, uint8_t dev_address, uint8_t *data, uint16_t size);
+i2c_status_e i2c_master_write_async(i2c_t *obj, uint8_t dev_address, uint8_t *data,
+                                    uint16_t size, void (*callback)(void *arg), void *arg);
+i2c_status_e i2c_master_read_async(i2c_t *obj, uint8_t dev_address, uint8_t *data,
+                                   uint16_t size, void (*callback)(void *arg), void *arg);
+i2c_status_e i2c_master_mem_write(i2c_t *obj, uint8_t dev_address,
+                                  uint16_t mem_address, uint8_t mem_size,
+                                  uint8_t *data, uint16_t size);
+i2c_status_e i2c_master_mem_read(i2c_t *obj, uint8_t dev_address,
+                                 uint16_t mem_address, uint8_t mem_size,
+                                 uint8_t *data, uint16_t size);
+i2c_status_e i2c_master_mem_write_async(i2c_t *obj, uint8_t dev_address,
+                                        uint16_t mem_address, uint8_t mem_size,
+                                        uint8_t *data, uint16_t size,
+                                        void (*callback)(void *arg), void *arg);
+i2c_status_e i2c_master_mem_read_async(i2c_t *obj, uint8_t dev_address,
+                                       uint16_t mem_address, uint8_t mem_size,
+                                       uint8_t *data, uint16_t size,
+                                       void (*callback)(void *arg), void *arg);
+i2c_status_e i2c_master_wait(i2c_t *obj);
+bool i2c_master_poll(i2c_t *obj);
+#if defined(I2C_DMA_ENABLED)
+void i2c_attach_dma(i2c_t *obj);
+#endif
 
 i2c_status_e i2c_IsDeviceReady(i2c_t *obj, uint8_t devAddr, uint32_t trials);
 